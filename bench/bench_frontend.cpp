@@ -0,0 +1,189 @@
+// Front-end benchmark: lexes, parses and flattens a script and reports
+// throughput and peak RSS per stage, plus the memory taken by the tree and
+// flat ASTs. Each stage runs in its own forked process, so the peak RSS it
+// reports is that stage's alone.
+//
+//   bench_frontend <guion.sst> [-j <n>]
+
+#include <algorithm>
+#include <ast.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <flat_ast.hpp>
+#include <frontend.hpp>
+#include <iostream>
+#include <lexer.hpp>
+#include <source.hpp>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+struct StageResult {
+  double seconds = 0;
+  uint64_t tokens = 0;
+  uint64_t nodes = 0;
+  uint64_t treeBytes = 0;
+  uint64_t flatBytes = 0;
+  long peakRssKb = 0;
+};
+
+// Directory of this binary. Passed to the parser as the compiler path, so
+// that scripts with imports keep their module cache next to the binaries
+// instead of in the working directory.
+std::string binaryDir() {
+  std::error_code ec;
+  std::filesystem::path exe =
+      std::filesystem::read_symlink("/proc/self/exe", ec);
+  return ec ? "." : exe.parent_path().string();
+}
+
+uint64_t countNodes(const ASTNode &node) {
+  uint64_t count = 1;
+  switch (node.kind) {
+  case NodeKind::LABEL:
+    for (const auto &stmt : static_cast<const LabelNode &>(node).statements)
+      count += countNodes(*stmt);
+    break;
+  case NodeKind::CHOICE:
+    count += static_cast<const ChoiceNode &>(node).options.size();
+    break;
+  case NodeKind::CHARACTER:
+    count += static_cast<const CharacterNode &>(node).modes.size();
+    break;
+  default:
+    break;
+  }
+  return count;
+}
+
+StageResult lexStage(const char *path) {
+  StageResult result;
+  auto start = std::chrono::steady_clock::now();
+  SourceFile source(path);
+  Lexer lexer(source.text());
+  while (lexer.nextToken().type != TokenType::END_OF_FILE)
+    ++result.tokens;
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+StageResult parseStage(const char *path, unsigned jobs) {
+  StageResult result;
+  auto start = std::chrono::steady_clock::now();
+  auto program = parseScript(path, binaryDir(), jobs);
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  for (const auto &stmt : program->statements)
+    result.nodes += countNodes(*stmt);
+  result.treeBytes = program->statements.capacity() * sizeof(ASTNode *);
+  for (const auto &arena : program->arenas)
+    result.treeBytes += arena->bytesUsed();
+  return result;
+}
+
+// Parses untimed, then times flatten(). Run apart from parseStage so that
+// the parse stage's peak RSS does not include the flat copy.
+StageResult flattenStage(const char *path, unsigned jobs) {
+  StageResult result;
+  auto program = parseScript(path, binaryDir(), jobs);
+  for (const auto &stmt : program->statements)
+    result.nodes += countNodes(*stmt);
+  auto start = std::chrono::steady_clock::now();
+  FlatProgram flat = flatten(*program);
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.flatBytes = flat.bytes();
+  return result;
+}
+
+// Runs stage in a child process and returns what it measured.
+template <typename Stage> bool runIsolated(Stage stage, StageResult &result) {
+  int fds[2];
+  if (pipe(fds) != 0)
+    return false;
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    StageResult measured;
+    try {
+      measured = stage();
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      _exit(1);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    measured.peakRssKb = usage.ru_maxrss;
+    ssize_t n = write(fds[1], &measured, sizeof(measured));
+    _exit(n == sizeof(measured) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  ssize_t n = read(fds[0], &result, sizeof(result));
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return n == sizeof(result) && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+void report(const char *stage, const StageResult &r, double megabytes) {
+  std::printf("  %-6s %9.3f s %9.1f MB/s %12.0f tokens/s %12.0f nodes/s "
+              "%9.1f MB RSS\n",
+              stage, r.seconds, megabytes / r.seconds,
+              r.tokens ? r.tokens / r.seconds : 0.0,
+              r.nodes ? r.nodes / r.seconds : 0.0, r.peakRssKb / 1024.0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const char *path = nullptr;
+  unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      jobs = std::max(1, std::atoi(argv[++i]));
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    std::cerr << "Uso: bench_frontend <guion.sst> [-j <n>]" << std::endl;
+    return 1;
+  }
+
+  double megabytes;
+  {
+    SourceFile source(path);
+    megabytes = source.text().size() / (1024.0 * 1024.0);
+  }
+  std::printf("%s (%.1f MB, %u hilos)\n", path, megabytes, jobs);
+
+  StageResult lex, parse, flat;
+  if (!runIsolated([&] { return lexStage(path); }, lex) ||
+      !runIsolated([&] { return parseStage(path, jobs); }, parse) ||
+      !runIsolated([&] { return flattenStage(path, jobs); }, flat)) {
+    std::cerr << "Error: falló una etapa del benchmark." << std::endl;
+    return 1;
+  }
+  report("lex", lex, megabytes);
+  report("parse", parse, megabytes);
+  report("flat", flat, megabytes);
+  std::printf("  ast    árbol %.1f MB, plano %.1f MB (%.1fx)\n",
+              parse.treeBytes / (1024.0 * 1024.0),
+              flat.flatBytes / (1024.0 * 1024.0),
+              flat.flatBytes ? double(parse.treeBytes) / flat.flatBytes : 0.0);
+  return 0;
+}
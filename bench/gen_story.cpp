@@ -0,0 +1,270 @@
+// Deterministic generator of synthetic .sst stories for benchmarking.
+//
+//   gen_story <tamaño> <salida.sst> [--seed N] [--choice-rate P]
+//             [--param-rate P] [--dialogue-words N] [--label-lines N]
+//
+// The size accepts K/M/G suffixes. The same arguments always produce the
+// same bytes.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct Options {
+  uint64_t size = 0;
+  std::string output;
+  uint64_t seed = 0x5eed;
+  double choiceRate = 0.15;
+  double paramRate = 0.3;
+  int dialogueWords = 40;
+  int labelLines = 24;
+};
+
+class Random {
+  uint64_t state;
+
+public:
+  explicit Random(uint64_t seed) : state(seed ? seed : 1) {}
+
+  uint64_t next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+  }
+  int below(int n) { return static_cast<int>(next() % n); }
+  double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+  bool chance(double p) { return unit() < p; }
+};
+
+const char *const WORDS[] = {
+    "el",     "la",      "sol",      "tarde",     "escuela",    "examen",
+    "amigo",  "arcade",  "silencio", "luz",       "biblioteca", "camino",
+    "mañana", "decides", "sientes",  "pregunta",  "respuesta",  "rapido",
+    "lento",  "noche",   "ciudad",   "recuerdo",  "promesa",    "secreto",
+    "de",     "que",     "y",        "con",       "sin",        "por"};
+constexpr int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+constexpr int BACKGROUNDS = 12;
+constexpr int MUSIC = 6;
+constexpr int CHARACTERS = 8;
+constexpr int MODES = 4;
+
+uint64_t parseSize(const char *text) {
+  char *end = nullptr;
+  double value = std::strtod(text, &end);
+  uint64_t unit = 1;
+  switch (*end) {
+  case 'k':
+  case 'K':
+    unit = 1ULL << 10;
+    break;
+  case 'm':
+  case 'M':
+    unit = 1ULL << 20;
+    break;
+  case 'g':
+  case 'G':
+    unit = 1ULL << 30;
+    break;
+  default:
+    break;
+  }
+  return static_cast<uint64_t>(value * unit);
+}
+
+class StoryWriter {
+  static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+  FILE *file;
+  std::string buffer;
+  uint64_t written = 0;
+
+public:
+  explicit StoryWriter(FILE *f) : file(f) { buffer.reserve(FLUSH_SIZE * 2); }
+  ~StoryWriter() { flush(); }
+
+  uint64_t size() const { return written + buffer.size(); }
+
+  StoryWriter &operator<<(const std::string &s) {
+    buffer += s;
+    if (buffer.size() >= FLUSH_SIZE)
+      flush();
+    return *this;
+  }
+  StoryWriter &operator<<(const char *s) { return *this << std::string(s); }
+  StoryWriter &operator<<(int n) { return *this << std::to_string(n); }
+
+  void flush() {
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    written += buffer.size();
+    buffer.clear();
+  }
+};
+
+std::string sentence(Random &rng, int maxWords) {
+  int words = 3 + rng.below(maxWords);
+  std::string text;
+  for (int i = 0; i < words; ++i) {
+    if (i)
+      text += ' ';
+    text += WORDS[rng.below(WORD_COUNT)];
+  }
+  text += '.';
+  return text;
+}
+
+std::string label(int index) {
+  return index == 0 ? "start" : "label_" + std::to_string(index);
+}
+
+void writeAssets(StoryWriter &out) {
+  out << "# Fondos\n";
+  for (int i = 0; i < BACKGROUNDS; ++i) {
+    out << "background fondo_" << i << " (\"./assets/backgrounds/fondo_" << i
+        << ".png\")\n";
+  }
+  out << "\n# Musica\n";
+  for (int i = 0; i < MUSIC; ++i) {
+    out << "music pista_" << i << " \"./assets/music/pista_" << i
+        << ".wav\"\n";
+  }
+  out << "\n# Personajes\n";
+  for (int c = 0; c < CHARACTERS; ++c) {
+    out << "define pj_" << c << " \"Personaje " << c << "\" {\n";
+    for (int m = 0; m < MODES; ++m) {
+      out << "    modo_" << m << ": (\"./assets/characters/pj_" << c
+          << "/modo_" << m << ".png\", scale: 0.7)"
+          << (m + 1 < MODES ? ",\n" : "\n");
+    }
+    out << "}\n\n";
+  }
+}
+
+void writeLabel(StoryWriter &out, Random &rng, const Options &opts, int index,
+                bool last) {
+  out << "label " << label(index) << ":\n";
+  out << "scene fondo_" << rng.below(BACKGROUNDS);
+  if (rng.chance(opts.paramRate))
+    out << " (x: 0, y: 0, scale: 1.0)";
+  out << "\n";
+  if (rng.chance(0.3))
+    out << "play pista_" << rng.below(MUSIC) << "\n";
+
+  int lines = 1 + rng.below(opts.labelLines);
+  for (int i = 0; i < lines; ++i) {
+    int roll = rng.below(10);
+    int character = rng.below(CHARACTERS);
+    if (roll < 2) {
+      out << "show pj_" << character << " modo_" << rng.below(MODES);
+      if (rng.chance(opts.paramRate))
+        out << " (x: " << rng.below(1400) << ", y: " << rng.below(200) << ")";
+      out << "\n";
+    } else if (roll < 3) {
+      out << "hide pj_" << character << "\n";
+    } else if (roll < 4) {
+      out << "# " << sentence(rng, 8) << "\n";
+    } else {
+      if (rng.chance(0.3))
+        out << "\"" << sentence(rng, opts.dialogueWords) << "\"";
+      else
+        out << "pj_" << character << " \""
+            << sentence(rng, opts.dialogueWords) << "\"";
+      if (rng.chance(opts.paramRate))
+        out << " (speed: " << 20 + rng.below(40) << ")";
+      out << "\n";
+    }
+  }
+
+  if (last) {
+    out << "end\n\n";
+  } else if (rng.chance(opts.choiceRate)) {
+    out << "choice \"" << sentence(rng, 6) << "\"\n";
+    int options = 2 + rng.below(3);
+    for (int i = 0; i < options; ++i) {
+      int target = i == 0 ? index + 1 : rng.below(index + 2);
+      out << "    option \"" << sentence(rng, 8) << "\" -> " << label(target)
+          << "\n";
+    }
+    out << "\n";
+  } else {
+    out << "jump " << label(index + 1) << "\n\n";
+  }
+}
+
+void printHelp() {
+  std::cout << "Uso: gen_story <tamaño> <salida.sst> [opciones]\n"
+            << "\n"
+            << "Opciones:\n"
+            << "  --seed <n>             Semilla del generador.\n"
+            << "  --choice-rate <p>      Probabilidad de terminar una etiqueta "
+               "con 'choice'.\n"
+            << "  --param-rate <p>       Probabilidad de añadir parámetros.\n"
+            << "  --dialogue-words <n>   Palabras máximas por diálogo.\n"
+            << "  --label-lines <n>      Sentencias máximas por etiqueta.\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options opts;
+  int positional = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "-h" || arg == "--help") {
+      printHelp();
+      return 0;
+    } else if (arg == "--seed" && hasValue) {
+      opts.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--choice-rate" && hasValue) {
+      opts.choiceRate = std::atof(argv[++i]);
+    } else if (arg == "--param-rate" && hasValue) {
+      opts.paramRate = std::atof(argv[++i]);
+    } else if (arg == "--dialogue-words" && hasValue) {
+      opts.dialogueWords = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--label-lines" && hasValue) {
+      opts.labelLines = std::max(1, std::atoi(argv[++i]));
+    } else if (positional == 0) {
+      opts.size = parseSize(argv[i]);
+      ++positional;
+    } else if (positional == 1) {
+      opts.output = arg;
+      ++positional;
+    } else {
+      printHelp();
+      return 1;
+    }
+  }
+
+  if (positional != 2 || opts.size == 0) {
+    printHelp();
+    return 1;
+  }
+
+  FILE *file = std::fopen(opts.output.c_str(), "wb");
+  if (!file) {
+    std::cerr << "Error: No se pudo abrir " << opts.output << std::endl;
+    return 1;
+  }
+
+  {
+    StoryWriter out(file);
+    Random rng(opts.seed);
+    writeAssets(out);
+    int index = 0;
+    while (out.size() < opts.size) {
+      writeLabel(out, rng, opts, index, false);
+      ++index;
+    }
+    writeLabel(out, rng, opts, index, true);
+  }
+  std::fclose(file);
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <cstddef>
+
+alignas(4) extern const char STORY_DATA[5259] =
+    "SSTB\001\000\000\000A\000\000\000\003\000\000\000\002\000\000\000\003\000\000\000\005\000\000\000@\000\000\000\006\000\000\000~\013\000\000\000\000\000\000\000\000\000\000\015\000\000\000\015\000\000\000;\000\000\000H\000\000\000"
+    "\012\000\000\000R\000\000\000<\000\000\000\216\000\000\000\006\000\000\000\224\000\000\0007\000\000\000\313\000\000\000\016\000\000\000\331\000\000\000(\000\000\000\001\001\000\000\020\000\000\000\021\001\000\000(\000\000\0009\001\000\000"
+    "\004\000\000\000=\001\000\000\007\000\000\000D\001\000\000\012\000\000\000N\001\000\000<\000\000\000\212\001\000\000\005\000\000\000\217\001\000\000\005\000\000\000\224\001\000\000\012\000\000\000\236\001\000\000>\000\000\000\334\001\000\000"
+    "\006\000\000\000\342\001\000\000:\000\000\000\034\002\000\000\004\000\000\000 \002\000\000\004\000\000\000$\002\000\000\005\000\000\000)\002\000\0007\000\000\000`\002\000\000\011\000\000\000i\002\000\000;\000\000\000\244\002\000\000"
+    "\003\000\000\000\247\002\000\000p\000\000\000\027\003\000\000R\000\000\000i\003\000\000\012\000\000\000s\003\000\000\036\000\000\000\221\003\000\000\031\000\000\000\252\003\000\000m\000\000\000\027\004\000\000P\000\000\000g\004\000\000"
+    "\026\000\000\000}\004\000\000B\000\000\000\277\004\000\000\012\000\000\000\311\004\000\000\020\000\000\000\331\004\000\000%\000\000\000\376\004\000\000,\000\000\000*\005\000\000_\000\000\000\211\005\000\000,\000\000\000\265\005\000\000"
+    "L\000\000\000\001\006\000\0006\000\000\0007\006\000\000\134\000\000\000\223\006\000\000H\000\000\000\333\006\000\000_\000\000\000:\007\000\000L\000\000\000\206\007\000\000/\000\000\000\265\007\000\000+\000\000\000\340\007\000\000"
+    "$\000\000\000\004\010\000\000!\000\000\000%\010\000\000#\000\000\000H\010\000\000b\000\000\000\252\010\000\000d\000\000\000\016\011\000\000(\000\000\0006\011\000\000\030\000\000\000N\011\000\000 \000\000\000n\011\000\000"
+    "y\000\000\000\347\011\000\000r\000\000\000Y\012\000\000\026\000\000\000o\012\000\000j\000\000\000\331\012\000\000\027\000\000\000\360\012\000\000a\000\000\000Q\013\000\000-\000\000\000\000\000\000\000\001\000\000\000\002\000\000\000"
+    "\003\000\000\000\004\000\000\000\005\000\000\000\006\000\000\000\007\000\000\000\010\000\000\000\011\000\000\000\012\000\000\000\013\000\000\000\000\000\000\000\001\000\000\000\016\000\000\000\017\000\000\000\001\000\000\000\002\000\000\000\024\000\000\000"
+    "\025\000\000\000\003\000\000\000\002\000\000\000\014\000\000\000\015\000\000\000333\077333\077\020\000\000\000\021\000\000\000333\077333\077\022\000\000\000\023\000\000\000333\077333\077\026\000\000\000"
+    "\027\000\000\000333\077333\077\030\000\000\000\031\000\000\000333\077333\077\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000\006\000\000\000\000\000\000\000"
+    "\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\032\000\000\000\033\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\001\000\000\000\012\000\000\000\014\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000"
+    "\012\000\000\000\034\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\006\000\000\000\035\000\000\000\000\000\000\000\002\000\000\000\000\000\000\000\000\000\000\000\005\000\000\000\006\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+    "\000\000\000\000\000\000\000\000\002\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\032\000\000\000 \000\000\000"
+    "\000\000\000\000\000\000\360A\000\000\000\000\001\000\000\000\024\000\000\000\026\000\000\000\000\000\000\000\000\000/D\000\000\000\000\003\000\000\000\032\000\000\000!\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000"
+    "\012\000\000\000\042\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\024\000\000\000#\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\006\000\000\000$\000\000\000\002\000\000\000\002\000\000\000\000\000\000\000"
+    "\000\000\000\000\002\000\000\000\024\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\001\000\000\000\024\000\000\000\030\000\000\000\000\000\000\000\000\000/D\000\000\000\000\003\000\000\000\012\000\000\000'\000\000\000"
+    "\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\032\000\000\000(\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\024\000\000\000)\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000"
+    "\032\000\000\000*\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\007\000\000\000.\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\012\000\000\000+\000\000\000\000\000\000\000\000\000\360A"
+    "\000\000\000\000\003\000\000\000\032\000\000\000,\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\032\000\000\000-\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\007\000\000\0004\000\000\000\000\000\000\000"
+    "\000\000\000\000\000\000\000\000\000\000\000\000\005\000\000\000\006\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000"
+    "\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\032\000\000\000.\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\001\000\000\000\016\000\000\000\020\000\000\000\000\000\000\000\000\000/D"
+    "\000\000\000\000\003\000\000\000\032\000\000\000/\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\016\000\000\0000\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\012\000\000\0001\000\000\000"
+    "\000\000\000\000\000\000\360A\000\000\000\000\006\000\000\000$\000\000\000\004\000\000\000\002\000\000\000\000\000\000\000\000\000\000\000\002\000\000\000\016\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\001\000\000\000"
+    "\016\000\000\000\022\000\000\000\000\000\000\000\000\000/D\000\000\000\000\003\000\000\000\016\000\000\0004\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\032\000\000\0005\000\000\000\000\000\000\000\000\000\360A"
+    "\000\000\000\000\003\000\000\000\032\000\000\0006\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\007\000\000\000:\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\012\000\000\0007\000\000\000"
+    "\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\016\000\000\0008\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\012\000\000\0009\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000"
+    "\032\000\000\000:\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\007\000\000\0004\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\005\000\000\000\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+    "\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000\006\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\032\000\000\000;\000\000\000"
+    "\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\032\000\000\000<\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\005\000\000\000"
+    "\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000\006\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"
+    "\000\000\000\000\003\000\000\000\032\000\000\000=\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\032\000\000\000>\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\010\000\000\000\000\000\000\000\000\000\000\000"
+    "\000\000\000\000\000\000\000\000\000\000\000\000\005\000\000\000\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\004\000\000\000"
+    "\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\003\000\000\000\032\000\000\000\077\000\000\000\000\000\000\000\000\000\360A\000\000\000\000\003\000\000\000\032\000\000\000@\000\000\000\000\000\000\000\000\000\360A"
+    "\000\000\000\000\010\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\036\000\000\000\006\000\000\000\037\000\000\000\032\000\000\000%\000\000\000\017\000\000\000&\000\000\000\026\000\000\0002\000\000\000"
+    "#\000\000\0003\000\000\000)\000\000\000patio_escuela/root/repo/test/./assets/backgrounds/sm"
+    "p_front_evening2.pngbiblioteca/root/repo/test/./assets/backgroun"
+    "ds/smp_classroom2_day1.pngarcade/root/repo/test/./assets/backgro"
+    "unds/smp_club3_day1.pngtema_principal/root/repo/test/./assets/mu"
+    "sic/Relax.wavtema_melancolico/root/repo/test/./assets/music/Deat"
+    "h.wavhiroHiroshipreocupado/root/repo/test/./assets/characters/hi"
+    "ro/hiro_preocupado.pngakiraAkiraenergetico/root/repo/test/./asse"
+    "ts/characters/akira/akira_energetico.pngriendo/root/repo/test/./"
+    "assets/characters/akira/akira_riendo.pngyukiYukiseria/root/repo/"
+    "test/./assets/characters/yuki/yuki_seria.pngsonriendo/root/repo/"
+    "test/./assets/characters/yuki/yuri_sonriendo.pngYouEl sol de la "
+    "tarde baniaba el patio de la escuela. Los examenes finales se ac"
+    "ercaban, y la presion era palpable.(Deberia estudiar para el exa"
+    "men de maniana... pero tambien necesito un descanso.)Que haras\077I"
+    "r a la biblioteca a estudiar.Ir al arcade a relajarme.Decides ir"
+    " a la biblioteca. El silencio es casi ensordecedor, solo roto po"
+    "r el suave murmullo de las paginas.Encuentras a Yuki, concentrad"
+    "a en sus apuntes, con una expresion de frustracion.Hola, Yuki. T"
+    "odo bien\077Hiroshi... si, solo este problema de calculo. No logro "
+    "entenderlo.Que haces\077Ofrecerle ayuda.Concentrarte en tus propios"
+    " estudios.Dejame ver. Creo que puedo ayudarte con eso.Pasas la s"
+    "iguiente hora explicando el problema a Yuki. Su rostro se ilumin"
+    "a con la comprension.Muchas gracias, Hiroshi! Eres un salvavidas"
+    "!Estudian juntos un rato mas. La tarde pasa volando, y te siente"
+    "s satisfecho.Entiendo. Yo tambien tengo que concentrarme en lo m"
+    "io.Te sumerges en tus libros, ignorando la lucha de Yuki. Logras"
+    " avanzar mucho en tus estudios.Al final, Yuki se rinde con un su"
+    "spiro y se va. Te sientes un poco solo.Decides ir al arcade. El "
+    "lugar esta lleno de luces parpadeantes y el sonido de los videoj"
+    "uegos.Akira te saluda con su energia habitual, ya inmerso en una"
+    " partida de baile.Hiro! Justo a tiempo! Esta maquina es adictiva"
+    "!(Quizas un par de partidas no hagan danio.)Unirte a Akira para "
+    "una partida mas.Decidir que es hora de ir a casa.Asi se habla! U"
+    "na mas y lo dejamos!Una partida se convierte en dos, luego en tr"
+    "es... El tiempo vuela mientras te diviertes con Akira.Cuando fin"
+    "almente sales del arcade, el sol ya se ha puesto. Te das cuenta "
+    "de que no estudiaste nada.Mejor me voy a casa. Tengo que estudia"
+    "r.Oh, vamos! Solo una mas!No, en serio. Nos vemos maniana.Te des"
+    "pides de Akira y te diriges a casa. Te sientes un poco culpable "
+    "por no haber estudiado, pero al menos te relajaste.El examen de "
+    "maniana no parece tan intimidante ahora. Te sientes bien contigo"
+    " mismo y con la conexion que hiciste.Un buen dia, sin duda.El di"
+    "a termino. No fue el mejor, pero tampoco el peor. El examen de m"
+    "aniana sigue siendo una preocupacion.Un dia normal, supongo.El d"
+    "ia termino con un sabor amargo. El examen de maniana se cierne s"
+    "obre ti como una nube oscura.Quizas debiste haber tomado otras d"
+    "ecisiones."
+    ;
+extern const size_t STORY_SIZE = 5258;
@@ -1,62 +1,21 @@
-#include "ast.hpp"
-#include <filesystem>
-#include <fstream>
-#include <iomanip>
-#include <stdexcept>
-#include <vector>
-
-std::string escapeJsonString(const std::string &s) {
-  std::string escaped;
-  for (char c : s) {
-    switch (c) {
-    case '"':
-      escaped += "\\\"";
-      break;
-    case '\\':
-      escaped += "\\\\";
-      break;
-    case '\b':
-      escaped += "\\b";
-      break;
-    case '\f':
-      escaped += "\\f";
-      break;
-    case '\n':
-      escaped += "\\n";
-      break;
-    case '\r':
-      escaped += "\\r";
-      break;
-    case '\t':
-      escaped += "\\t";
-      break;
-    default:
-      escaped += c;
-      break;
-    }
-  }
-  return escaped;
-}
-
-void generateEngineCode(std::ostream &out, const std::string &compilerPath) {
-  std::string story_json_path_str = compilerPath + "/.tmp/story.json";
-
-  out << R"__(#include <SFML/Audio.hpp>
+#include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
 #include <cstddef>
-#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <optional>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
-#include "nlohmann_json.hpp"
-
-using json = nlohmann::json;
-
 constexpr int WINDOW_WIDTH = 1600;
 constexpr int WINDOW_HEIGHT = 800;
 constexpr int TEXT_BOX_POSX = 0;
@@ -133,6 +92,179 @@ public:
   }
 };
 
+// Mirrors include/story_format.hpp in the compiler.
+using StringId = uint32_t;
+constexpr StringId NO_STRING = UINT32_MAX;
+constexpr uint32_t STORY_VERSION = 1;
+constexpr uint32_t STORY_NO_ENTRY = UINT32_MAX;
+
+struct StoryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t strings;
+  uint32_t backgrounds;
+  uint32_t music;
+  uint32_t characters;
+  uint32_t modes;
+  uint32_t commands;
+  uint32_t options;
+  uint32_t textBytes;
+  uint32_t entry;
+};
+
+struct StoryString {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct StoryAsset {
+  StringId name;
+  StringId path;
+};
+
+struct StoryCharacter {
+  StringId name;
+  StringId displayName;
+  uint32_t firstMode;
+  uint32_t modeCount;
+};
+
+struct StoryMode {
+  StringId name;
+  StringId path;
+  float scaleX;
+  float scaleY;
+};
+
+enum class StoryOp : uint32_t {
+  SCENE,
+  SHOW,
+  HIDE,
+  DIALOGUE,
+  PLAY,
+  STOP,
+  CHOICE,
+  JUMP,
+  END
+};
+
+struct StoryCommand {
+  StoryOp op;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  float x;
+  float y;
+};
+
+struct StoryOption {
+  StringId text;
+  uint32_t target;
+};
+
+#ifdef STORY_EMBEDDED
+// The story image linked into the game; see generateStorySource().
+extern const char STORY_DATA[];
+extern const size_t STORY_SIZE;
+#endif
+
+// story.bin mapped read-only, or the image built into the game. Commands and
+// strings are used in place.
+class Story {
+  void *data_ = MAP_FAILED;
+  size_t size_ = 0;
+  const StoryHeader *header_ = nullptr;
+  const StoryString *strings_ = nullptr;
+  const StoryAsset *backgrounds_ = nullptr;
+  const StoryAsset *music_ = nullptr;
+  const StoryCharacter *characters_ = nullptr;
+  const StoryMode *modes_ = nullptr;
+  const StoryCommand *commands_ = nullptr;
+  const StoryOption *options_ = nullptr;
+  const char *text_ = nullptr;
+
+  template <typename T> static const T *take(const char *&p, uint32_t count) {
+    const T *array = reinterpret_cast<const T *>(p);
+    p += sizeof(T) * count;
+    return array;
+  }
+
+  bool validate(size_t size) const {
+    const StoryHeader &h = *header_;
+    if (std::memcmp(h.magic, "SSTB", 4) != 0 || h.version != STORY_VERSION)
+      return false;
+    size_t expected = sizeof(StoryHeader) + sizeof(StoryString) * h.strings +
+                      sizeof(StoryAsset) * (size_t(h.backgrounds) + h.music) +
+                      sizeof(StoryCharacter) * h.characters +
+                      sizeof(StoryMode) * h.modes +
+                      sizeof(StoryCommand) * h.commands +
+                      sizeof(StoryOption) * h.options + h.textBytes;
+    return expected == size;
+  }
+
+public:
+  Story() = default;
+  Story(const Story &) = delete;
+  Story &operator=(const Story &) = delete;
+  ~Story() { close(); }
+
+  void close() {
+    if (data_ != MAP_FAILED)
+      munmap(data_, size_);
+    data_ = MAP_FAILED;
+    size_ = 0;
+  }
+
+  bool open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(StoryHeader)) {
+      ::close(fd);
+      return false;
+    }
+    size_ = st.st_size;
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data_ == MAP_FAILED)
+      return false;
+    return attach(static_cast<const char *>(data_), size_);
+  }
+
+  // Reads the story in place from size bytes at data, which must be 4-byte
+  // aligned and outlive the story.
+  bool attach(const char *data, size_t size) {
+    if (size < sizeof(StoryHeader))
+      return false;
+    const char *p = data;
+    header_ = take<StoryHeader>(p, 1);
+    if (!validate(size))
+      return false;
+    strings_ = take<StoryString>(p, header_->strings);
+    backgrounds_ = take<StoryAsset>(p, header_->backgrounds);
+    music_ = take<StoryAsset>(p, header_->music);
+    characters_ = take<StoryCharacter>(p, header_->characters);
+    modes_ = take<StoryMode>(p, header_->modes);
+    commands_ = take<StoryCommand>(p, header_->commands);
+    options_ = take<StoryOption>(p, header_->options);
+    text_ = p;
+    return true;
+  }
+
+  const StoryHeader &header() const { return *header_; }
+  std::string_view str(StringId id) const {
+    return {text_ + strings_[id].offset, strings_[id].size};
+  }
+  const StoryAsset *backgrounds() const { return backgrounds_; }
+  const StoryAsset *music() const { return music_; }
+  const StoryCharacter *characters() const { return characters_; }
+  const StoryMode *modes() const { return modes_; }
+  const StoryCommand &command(size_t index) const { return commands_[index]; }
+  const StoryOption *options() const { return options_; }
+};
+
 struct Transform {
   sf::Vector2f position = {0.0f, 0.0f};
   sf::Vector2f scale = {1.0f, 1.0f};
@@ -209,19 +341,19 @@ public:
 
 class Character : public SceneComponent {
   std::string id_, name_;
-  std::string currentState_;
-  std::map<std::string, std::unique_ptr<CharacterState>> states_;
+  StringId currentState_ = NO_STRING;
+  std::unordered_map<StringId, std::unique_ptr<CharacterState>> states_;
   bool isVisible_ = false;
 
 public:
   Character(const std::string &id, const std::string &name)
       : id_(id), name_(name) {}
-  void addState(const std::string &stateName, const std::string &texturePath,
+  void addState(StringId stateName, const std::string &texturePath,
                 const Transform &transform) {
     states_[stateName] =
         std::make_unique<GenericCharacterState>(texturePath, transform);
   }
-  void setState(const std::string &stateName) {
+  void setState(StringId stateName) {
     if (states_.count(stateName)) {
       currentState_ = stateName;
     }
@@ -348,6 +480,7 @@ public:
                     std::shared_ptr<SceneComponent> component) {
     components_.push_back(component);
   }
+  void clear() { components_.clear(); }
   void draw(sf::RenderWindow &window) {
     for (auto &comp : components_) {
       comp->draw(window);
@@ -360,53 +493,6 @@ public:
   }
 };
 
-struct DialogueCmd {
-  std::string speakerId;
-  std::string text;
-  float speed;
-};
-struct ShowCmd {
-  std::string characterId;
-  std::string mode;
-  Transform transform;
-};
-struct HideCmd {
-  std::string characterId;
-};
-struct SceneCmd {
-  std::string backgroundName;
-};
-struct PlayCmd {
-  std::string musicId;
-};
-struct StopCmd {
-  std::string musicId;
-};
-
-struct JumpCmd {
-  std::string targetLabel;
-};
-
-struct EndCmd {};
-
-struct ChoiceOptionCmd {
-  std::string text;
-  std::string gotoLabel;
-};
-
-struct ChoiceCmd {
-  std::string prompt;
-  std::vector<ChoiceOptionCmd> options;
-};
-
-struct LabelCmd {
-  std::string name;
-  size_t startIndex;
-};
-
-using StoryCommand = std::variant<DialogueCmd, ShowCmd, HideCmd, SceneCmd,
-                                  PlayCmd, StopCmd, ChoiceCmd, JumpCmd, EndCmd>;
-
 class ChoiceBox : public SceneComponent {
 private:
   sf::RectangleShape background_;
@@ -416,7 +502,7 @@ private:
   sf::Font font_;
   bool isVisible_ = false;
   int hoveredOption_ = -1;
-  std::vector<std::string> gotoLabels_;
+  std::vector<size_t> targets_;
 
 public:
   ChoiceBox(const sf::Font &font) : promptText_(font, ""), font_(font) {
@@ -427,11 +513,11 @@ public:
     promptText_.setFillColor(sf::Color::White);
   }
 
-  void setOptions(const std::string &prompt,
-                  const std::vector<ChoiceOptionCmd> &options) {
+  void setOptions(const std::string &prompt, const StoryOption *options,
+                  size_t count, const Story &story) {
     optionTexts_.clear();
     optionRects_.clear();
-    gotoLabels_.clear();
+    targets_.clear();
 
     promptText_.setString(
         wrapText(prompt, CHOICE_BOX_WIDTH * 0.9, font_, PROMPT_SIZE));
@@ -440,11 +526,13 @@ public:
         PROMPT_MARGIN * 2 + promptText_.getGlobalBounds().size.y;
     float optionWidth = background_.getSize().x * 0.9;
 
-    for (const auto &option : options) {
+    for (size_t i = 0; i < count; ++i) {
+      const StoryOption &option = options[i];
       sf::Text optionText(font_, "", TEXT_OPTION_SIZE);
       optionText.setFillColor(sf::Color::White);
-      std::string wrapped =
-          wrapText(option.text, optionWidth * 0.9, font_, TEXT_OPTION_SIZE);
+      std::string wrapped = wrapText(std::string(story.str(option.text)),
+                                     optionWidth * 0.9, font_,
+                                     TEXT_OPTION_SIZE);
       optionText.setString(wrapped);
 
       totalHeight += optionText.getGlobalBounds().size.y + OPTION_PADDING * 2 +
@@ -457,7 +545,7 @@ public:
 
       optionTexts_.push_back(optionText);
       optionRects_.push_back(optionRect);
-      gotoLabels_.push_back(option.gotoLabel);
+      targets_.push_back(option.target);
     }
 
     background_.setSize(
@@ -549,9 +637,7 @@ public:
     }
   }
 
-  const std::string &getGotoLabel(int index) const {
-    return gotoLabels_[index];
-  }
+  size_t getTarget(int index) const { return targets_[index]; }
 };
 
 class VisualNovelEngine {
@@ -578,28 +664,23 @@ public:
     dialogueSystem_ = std::make_shared<DialogueSystem>(font_);
     choiceBox_ = std::make_shared<ChoiceBox>(font_);
 
+    storyPath_ = storyPath;
     if (!loadStoryFromFile(storyPath)) {
       std::cerr << "Error: No se pudo cargar la historia desde " << storyPath
                 << std::endl;
       return;
     }
-
-    if (!storyScript_.empty()) {
-      if (labelMap_.count("start")) {
-        commandIndex_ = labelMap_["start"];
-      } else {
-        std::cerr << "Error: 'start' label not found in story.json\n";
-        currentState_ = State::IDLE;
-        return;
-      }
-      currentState_ = State::EXECUTING_COMMAND;
-    }
+    begin();
   }
 
   void run() {
     sf::Clock clock;
     while (window_.isOpen()) {
       sf::Time elapsed = clock.restart();
+#ifndef STORY_EMBEDDED
+      if (storyChanged(elapsed.asSeconds()))
+        reloadStory();
+#endif
       handleEvents();
       update(elapsed.asSeconds());
       render();
@@ -613,101 +694,127 @@ private:
   sf::Font font_;
   SceneManager sceneManager_;
 
-  std::map<std::string, std::shared_ptr<Character>> characters_;
-  std::map<std::string, std::shared_ptr<Background>> backgrounds_;
-  std::map<std::string, std::shared_ptr<sf::Music>> musicTracks_;
+  Story story_;
+  std::string storyPath_;
+#ifndef STORY_EMBEDDED
+  // story.bin as it was when loaded; `compiler --watch` replaces the file.
+  ino_t storyInode_ = 0;
+  time_t storyTime_ = 0;
+  float sinceStoryCheck_ = 0.0f;
+#endif
+  // Assets by the string id of their name.
+  std::unordered_map<StringId, std::shared_ptr<Character>> characters_;
+  std::unordered_map<StringId, std::shared_ptr<Background>> backgrounds_;
+  std::unordered_map<StringId, std::shared_ptr<sf::Music>> musicTracks_;
 
   std::shared_ptr<DialogueSystem> dialogueSystem_;
   std::shared_ptr<ChoiceBox> choiceBox_;
-  std::vector<StoryCommand> storyScript_;
   size_t commandIndex_ = 0;
-  std::string currentBackground_;
-  std::string currentMusicId_;
-  std::map<std::string, size_t> labelMap_;
+  StringId currentBackground_ = NO_STRING;
+  StringId currentMusicId_ = NO_STRING;
 
   bool loadStoryFromFile(const std::string &path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
+#ifdef STORY_EMBEDDED
+    (void)path;
+    if (!story_.attach(STORY_DATA, STORY_SIZE)) {
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+      storyInode_ = st.st_ino;
+      storyTime_ = st.st_mtime;
+    }
+    if (!story_.open(path)) {
+#endif
       return false;
     }
-    json storyJson;
-    file >> storyJson;
-
-    const auto &assets = storyJson["assets"];
-    for (auto const &[key, val] : assets["backgrounds"].items()) {
-      auto bg = std::make_shared<Background>(val.get<std::string>());
-      backgrounds_[key] = bg;
-      sceneManager_.addComponent("bg_" + key, bg);
+    const StoryHeader &header = story_.header();
+
+    for (uint32_t i = 0; i < header.backgrounds; ++i) {
+      const StoryAsset &asset = story_.backgrounds()[i];
+      auto bg =
+          std::make_shared<Background>(std::string(story_.str(asset.path)));
+      backgrounds_[asset.name] = bg;
+      sceneManager_.addComponent("bg_" + std::string(story_.str(asset.name)),
+                                 bg);
     }
-    for (auto const &[key, val] : assets["music"].items()) {
+    for (uint32_t i = 0; i < header.music; ++i) {
+      const StoryAsset &asset = story_.music()[i];
+      std::string path(story_.str(asset.path));
       auto music = std::make_shared<sf::Music>();
-      if (music->openFromFile(val.get<std::string>())) {
-        musicTracks_[key] = music;
+      if (music->openFromFile(path)) {
+        musicTracks_[asset.name] = music;
       } else {
-        std::cerr << "Error al cargar música: " << val << "\n";
+        std::cerr << "Error al cargar música: " << path << "\n";
       }
     }
-    for (auto const &[key, val] : assets["characters"].items()) {
-      auto character =
-          std::make_shared<Character>(key, val["name"].get<std::string>());
-      for (auto const &[stateKey, stateVal] : val["states"].items()) {
+    for (uint32_t i = 0; i < header.characters; ++i) {
+      const StoryCharacter &entry = story_.characters()[i];
+      std::string key(story_.str(entry.name));
+      auto character = std::make_shared<Character>(
+          key, std::string(story_.str(entry.displayName)));
+      for (uint32_t m = 0; m < entry.modeCount; ++m) {
+        const StoryMode &mode = story_.modes()[entry.firstMode + m];
         Transform transform;
-        if (stateVal.contains("scale")) {
-          transform.scale = {stateVal["scale"][0].get<float>(),
-                             stateVal["scale"][1].get<float>()};
-        }
-        character->addState(stateKey, stateVal["path"].get<std::string>(),
+        transform.scale = {mode.scaleX, mode.scaleY};
+        character->addState(mode.name, std::string(story_.str(mode.path)),
                             transform);
       }
-      characters_[key] = character;
+      characters_[entry.name] = character;
       sceneManager_.addComponent("char_" + key, character);
     }
+    return true;
+  }
 
-    const auto &script = storyJson["script"];
-    for (const auto &labelEntry : script) {
-      std::string labelName = labelEntry["label"].get<std::string>();
-      const auto &commands = labelEntry["commands"];
-      labelMap_[labelName] = storyScript_.size();
-      for (const auto &cmdJson : commands) {
-        std::string commandType = cmdJson["command"].get<std::string>();
-        if (commandType == "scene") {
-          storyScript_.push_back(SceneCmd{cmdJson["background"]});
-        } else if (commandType == "play") {
-          storyScript_.push_back(PlayCmd{cmdJson["music"]});
-        } else if (commandType == "stop") {
-          storyScript_.push_back(StopCmd{cmdJson["music"]});
-        } else if (commandType == "show") {
-          Transform t;
-          if (cmdJson.contains("position")) {
-            t.position = {cmdJson["position"][0].get<float>(),
-                          cmdJson["position"][1].get<float>()};
-          }
-          storyScript_.push_back(
-              ShowCmd{cmdJson["character"], cmdJson["state"], t});
-        } else if (commandType == "hide") {
-          storyScript_.push_back(HideCmd{cmdJson["character"]});
-        } else if (commandType == "dialogue") {
-          storyScript_.push_back(DialogueCmd{cmdJson["speaker"],
-                                             cmdJson["text"],
-                                             cmdJson.value("speed", 30.0f)});
-        } else if (commandType == "choice") {
-          ChoiceCmd choiceCmd;
-          choiceCmd.prompt = cmdJson["prompt"].get<std::string>();
-          for (const auto &optionJson : cmdJson["options"]) {
-            choiceCmd.options.push_back(
-                ChoiceOptionCmd{optionJson["text"].get<std::string>(),
-                                optionJson["goto"].get<std::string>()});
-          }
-          storyScript_.push_back(choiceCmd);
-        } else if (commandType == "jump") {
-          storyScript_.push_back(JumpCmd{cmdJson["target"]});
-        } else if (commandType == "end") {
-          storyScript_.push_back(EndCmd{});
-        }
-      }
+  // Runs the story from its `start` label.
+  void begin() {
+    currentState_ = State::IDLE;
+    if (story_.header().commands == 0)
+      return;
+    if (story_.header().entry == STORY_NO_ENTRY) {
+      std::cerr << "Error: 'start' label not found in story.bin\n";
+      return;
     }
-    return true;
+    commandIndex_ = story_.header().entry;
+    currentState_ = State::EXECUTING_COMMAND;
+  }
+
+#ifndef STORY_EMBEDDED
+  // Whether story.bin was replaced since it was loaded. Checked a few times
+  // a second.
+  bool storyChanged(float deltaTime) {
+    sinceStoryCheck_ += deltaTime;
+    if (sinceStoryCheck_ < 0.25f)
+      return false;
+    sinceStoryCheck_ = 0.0f;
+    struct stat st;
+    if (stat(storyPath_.c_str(), &st) != 0)
+      return false;
+    return st.st_ino != storyInode_ || st.st_mtime != storyTime_;
+  }
+
+  // Drops the assets of the old story and starts the new one from the top.
+  void reloadStory() {
+    for (auto const &[id, music] : musicTracks_) {
+      music->stop();
+    }
+    characters_.clear();
+    backgrounds_.clear();
+    musicTracks_.clear();
+    sceneManager_.clear();
+    dialogueSystem_->hide();
+    choiceBox_->setVisibility(false);
+    currentBackground_ = NO_STRING;
+    currentMusicId_ = NO_STRING;
+    currentState_ = State::IDLE;
+    if (!loadStoryFromFile(storyPath_)) {
+      std::cerr << "Error: No se pudo cargar la historia desde " << storyPath_
+                << std::endl;
+      return;
+    }
+    std::cerr << "Historia recargada.\n";
+    begin();
   }
+#endif
 
   void update(float deltaTime) {
     if (currentState_ == State::EXECUTING_COMMAND) {
@@ -718,103 +825,101 @@ private:
   }
 
   void executeNextCommand() {
-    if (commandIndex_ >= storyScript_.size()) {
+    if (commandIndex_ >= story_.header().commands) {
       dialogueSystem_->hide();
       currentState_ = State::IDLE;
       std::cerr << "DEBUG: Reached end of script. commandIndex_ = "
                 << commandIndex_
-                << ", storyScript_.size() = " << storyScript_.size()
-                << std::endl;
+                << ", commands = " << story_.header().commands << std::endl;
       return;
     }
 
-    const auto &command = storyScript_[commandIndex_];
-    std::visit(
-        [this](auto &&arg) {
-          using T = std::decay_t<decltype(arg)>;
-          if constexpr (std::is_same_v<T, DialogueCmd>) {
-            std::string speakerName =
-                (arg.speakerId == "You") ? "" : arg.speakerId;
-            if (auto it = characters_.find(arg.speakerId);
-                it != characters_.end()) {
-              speakerName = it->second->getName();
-            }
-            for (auto const &[id, character] : characters_) {
-              character->setFocused(id == arg.speakerId ||
-                                    arg.speakerId == "You");
-            }
-            dialogueSystem_->start(
-                speakerName.empty() ? arg.text : speakerName + ":\n" + arg.text,
-                arg.speed);
-            currentState_ = State::WRITING_DIALOGUE;
-          } else if constexpr (std::is_same_v<T, ChoiceCmd>) {
-            dialogueSystem_->hide();
-            choiceBox_->setOptions(arg.prompt, arg.options);
-            currentState_ = State::WAITING_FOR_CHOICE;
-            if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
-              waitForMouseReleaseForChoice_ = true;
-            } else {
-              waitForMouseReleaseForChoice_ = false;
-            }
-          } else {
-            for (auto const &[id, character] : characters_) {
-              character->setFocused(true);
-            }
-            if constexpr (std::is_same_v<T, SceneCmd>) {
-              if (backgrounds_.count(currentBackground_))
-                backgrounds_[currentBackground_]->setVisibility(false);
-              if (backgrounds_.count(arg.backgroundName))
-                backgrounds_[arg.backgroundName]->setVisibility(true);
-              currentBackground_ = arg.backgroundName;
-            } else if constexpr (std::is_same_v<T, ShowCmd>) {
-              if (auto it = characters_.find(arg.characterId);
-                  it != characters_.end()) {
-                it->second->setState(arg.mode);
-                it->second->setPosition(arg.transform.position);
-                it->second->setVisibility(true);
-              }
-            } else if constexpr (std::is_same_v<T, HideCmd>) {
-              if (auto it = characters_.find(arg.characterId);
-                  it != characters_.end()) {
-                it->second->setVisibility(false);
-              }
-            } else if constexpr (std::is_same_v<T, PlayCmd>) {
-              if (!currentMusicId_.empty() &&
-                  musicTracks_.count(currentMusicId_)) {
-                musicTracks_[currentMusicId_]->stop();
-              }
-              if (musicTracks_.count(arg.musicId)) {
-                currentMusicId_ = arg.musicId;
-                musicTracks_[currentMusicId_]->setLooping(true);
-                musicTracks_[currentMusicId_]->play();
-              }
-            } else if constexpr (std::is_same_v<T, StopCmd>) {
-              if (musicTracks_.count(arg.musicId)) {
-                musicTracks_[arg.musicId]->stop();
-                if (currentMusicId_ == arg.musicId) {
-                  currentMusicId_.clear();
-                }
-              }
-            } else if constexpr (std::is_same_v<T, EndCmd>) {
-              window_.close();
-              currentState_ =
-                  State::IDLE;
-            } else if constexpr (std::is_same_v<T, JumpCmd>) {
-              if (labelMap_.count(arg.targetLabel)) {
-                commandIndex_ = labelMap_[arg.targetLabel];
-                currentState_ =
-                    State::EXECUTING_COMMAND; 
-              } else {
-                std::cerr << "Error: Jump target label \"" << arg.targetLabel
-                          << "\" not found.\n";
-                currentState_ = State::IDLE;
-              }
-            }
-            currentState_ = State::EXECUTING_COMMAND;
-            commandIndex_++;
-          }
-        },
-        command);
+    const StoryCommand &cmd = story_.command(commandIndex_);
+    if (cmd.op == StoryOp::DIALOGUE) {
+      std::string_view speakerId = story_.str(cmd.a);
+      bool narrator = speakerId == "You";
+      std::string speakerName = narrator ? "" : std::string(speakerId);
+      if (auto it = characters_.find(cmd.a); it != characters_.end()) {
+        speakerName = it->second->getName();
+      }
+      for (auto const &[id, character] : characters_) {
+        character->setFocused(id == cmd.a || narrator);
+      }
+      std::string text(story_.str(cmd.b));
+      dialogueSystem_->start(
+          speakerName.empty() ? text : speakerName + ":\n" + text, cmd.x);
+      currentState_ = State::WRITING_DIALOGUE;
+      return;
+    }
+    if (cmd.op == StoryOp::CHOICE) {
+      dialogueSystem_->hide();
+      choiceBox_->setOptions(std::string(story_.str(cmd.a)),
+                             story_.options() + cmd.b, cmd.c, story_);
+      currentState_ = State::WAITING_FOR_CHOICE;
+      if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
+        waitForMouseReleaseForChoice_ = true;
+      } else {
+        waitForMouseReleaseForChoice_ = false;
+      }
+      return;
+    }
+
+    for (auto const &[id, character] : characters_) {
+      character->setFocused(true);
+    }
+    switch (cmd.op) {
+    case StoryOp::SCENE:
+      if (auto it = backgrounds_.find(currentBackground_);
+          it != backgrounds_.end())
+        it->second->setVisibility(false);
+      if (auto it = backgrounds_.find(cmd.a); it != backgrounds_.end())
+        it->second->setVisibility(true);
+      currentBackground_ = cmd.a;
+      break;
+    case StoryOp::SHOW:
+      if (auto it = characters_.find(cmd.a); it != characters_.end()) {
+        it->second->setState(cmd.b);
+        it->second->setPosition({cmd.x, cmd.y});
+        it->second->setVisibility(true);
+      }
+      break;
+    case StoryOp::HIDE:
+      if (auto it = characters_.find(cmd.a); it != characters_.end()) {
+        it->second->setVisibility(false);
+      }
+      break;
+    case StoryOp::PLAY:
+      if (auto it = musicTracks_.find(currentMusicId_);
+          it != musicTracks_.end()) {
+        it->second->stop();
+      }
+      if (auto it = musicTracks_.find(cmd.a); it != musicTracks_.end()) {
+        currentMusicId_ = cmd.a;
+        it->second->setLooping(true);
+        it->second->play();
+      }
+      break;
+    case StoryOp::STOP:
+      if (auto it = musicTracks_.find(cmd.a); it != musicTracks_.end()) {
+        it->second->stop();
+        if (currentMusicId_ == cmd.a) {
+          currentMusicId_ = NO_STRING;
+        }
+      }
+      break;
+    case StoryOp::END:
+      window_.close();
+      currentState_ = State::IDLE;
+      break;
+    case StoryOp::JUMP:
+      commandIndex_ = cmd.a;
+      currentState_ = State::EXECUTING_COMMAND;
+      return;
+    default:
+      break;
+    }
+    currentState_ = State::EXECUTING_COMMAND;
+    commandIndex_++;
   }
 
   void handleEvents() {
@@ -849,19 +954,10 @@ private:
             int chosenOptionIndex =
                 choiceBox_->handleMouseClick(sf::Mouse::getPosition(window_));
             if (chosenOptionIndex != -1) {
-              const auto &currentCommand = storyScript_[commandIndex_];
-              if (const auto *choiceCmd =
-                      std::get_if<ChoiceCmd>(&currentCommand)) {
-                std::string targetLabel =
-                    choiceBox_->getGotoLabel(chosenOptionIndex);
-                if (labelMap_.count(targetLabel)) {
-                  commandIndex_ = labelMap_[targetLabel];
-                  currentState_ = State::EXECUTING_COMMAND;
-                  choiceBox_->setVisibility(false);
-                } else {
-                  std::cerr << "Error: Label \"" << targetLabel
-                            << "\" not found.\n";
-                }
+              if (story_.command(commandIndex_).op == StoryOp::CHOICE) {
+                commandIndex_ = choiceBox_->getTarget(chosenOptionIndex);
+                currentState_ = State::EXECUTING_COMMAND;
+                choiceBox_->setVisibility(false);
               }
             }
           }
@@ -883,8 +979,8 @@ private:
 };
 
 int main(int argc, char *argv[]) {
-  std::string storyFile = ")__" +
-             story_json_path_str + R"__(";
+  // Ignored when the story is built into the game.
+  std::string storyFile = "/root/repo/build/bin/.tmp/story.bin";
   if (argc > 1) {
     storyFile = argv[1];
   }
@@ -894,213 +990,3 @@ int main(int argc, char *argv[]) {
   engine.run();
   return 0;
 }
-)__";
-}
-
-void ProgramNode::generateCode(std::ostream &out, int indent) const {
-  std::string enginePath = compilerPath + "/.tmp/juego_generado.cpp";
-  std::ofstream engineFile(enginePath);
-
-  if (engineFile.is_open()) {
-    generateEngineCode(engineFile, compilerPath);
-    engineFile.close();
-  } else {
-    throw std::runtime_error("No se pudo abrir " + enginePath +
-                             " para escribir.");
-  }
-
-  out << "{\n";
-  out << "  \"assets\": {\n";
-  out << "    \"backgrounds\": {\n";
-  bool first = true;
-  for (const auto &stmt : statements) {
-    if (auto node = dynamic_cast<BackgroundNode *>(stmt.get())) {
-      if (!first)
-        out << ",\n";
-      node->generateCode(out, 6);
-      first = false;
-    }
-  }
-  out << "\n    },\n";
-  out << "    \"music\": {\n";
-  first = true;
-  for (const auto &stmt : statements) {
-    if (auto node = dynamic_cast<MusicNode *>(stmt.get())) {
-      if (!first)
-        out << ",\n";
-      node->generateCode(out, 6);
-      first = false;
-    }
-  }
-  out << "\n    },\n";
-  out << "    \"characters\": {\n";
-  first = true;
-  for (const auto &stmt : statements) {
-    if (auto node = dynamic_cast<CharacterNode *>(stmt.get())) {
-      if (!first)
-        out << ",\n";
-      node->generateCode(out, 6);
-      first = false;
-    }
-  }
-  out << "\n    }\n";
-
-  out << "  },\n";
-  out << "  \"script\": [\n";
-  bool firstLabel = true;
-  for (const auto &stmt : statements) {
-    if (auto labelNode = dynamic_cast<LabelNode *>(stmt.get())) {
-      if (!firstLabel)
-        out << ",\n";
-      labelNode->generateCode(out, 4);
-      firstLabel = false;
-    }
-  }
-  out << "\n  ]\n";
-
-  out << "}\n";
-}
-
-void BackgroundNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "\"" << name << "\": \""
-      << escapeJsonString(std::filesystem::absolute(imagePath).string())
-      << "\"";
-}
-
-void CharacterNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "\"" << id << "\": {\n";
-  out << std::string(indent + 2, ' ') << "\"name\": \""
-      << escapeJsonString(displayName) << "\",\n";
-  out << std::string(indent + 2, ' ') << "\"states\": {\n";
-  bool first = true;
-  for (const auto &mode : modes) {
-    if (!first)
-      out << ",\n";
-    out << std::string(indent + 4, ' ') << "\"" << mode->name << "\": { ";
-    out << "\"path\": \""
-        << escapeJsonString(std::filesystem::absolute(mode->imagePath).string())
-        << "\"";
-    for (const auto &[key, val] : mode->parameters) {
-      if (key == "scale") {
-        out << ", \"scale\": [" << std::get<double>(val) << ", "
-            << std::get<double>(val) << "]";
-      }
-    }
-    out << " }";
-    first = false;
-  }
-  out << "\n" << std::string(indent + 2, ' ') << "}\n";
-  out << std::string(indent, ' ') << "}";
-}
-
-void DialogueNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"dialogue\", ";
-  out << "\"speaker\": \"" << speaker << "\", ";
-  out << "\"text\": \"" << escapeJsonString(text) << "\"";
-  for (const auto &[key, val] : parameters) {
-    if (key == "speed") {
-      out << ", \"speed\": " << std::get<double>(val);
-    }
-  }
-  out << " }";
-}
-
-void ShowNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"show\", ";
-  out << "\"character\": \"" << characterId << "\", ";
-  out << "\"state\": \"" << mode << "\"";
-  double x = 0, y = 0;
-  bool pos_set = false;
-  for (const auto &[key, val] : parameters) {
-    if (key == "x") {
-      x = std::get<double>(val);
-      pos_set = true;
-    }
-    if (key == "y") {
-      y = std::get<double>(val);
-      pos_set = true;
-    }
-  }
-  if (pos_set) {
-    out << ", \"position\": [" << x << ", " << y << "]";
-  }
-  out << " }";
-}
-
-void HideNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"hide\", ";
-  out << "\"character\": \"" << characterId << "\" }";
-}
-
-void SceneNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"scene\", ";
-  out << "\"background\": \"" << name << "\" }";
-}
-
-void MusicNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "\"" << id << "\": \""
-      << escapeJsonString(std::filesystem::absolute(filePath).string()) << "\"";
-}
-
-void PlayNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"play\", ";
-  out << "\"music\": \"" << musicId << "\" }";
-}
-
-void StopNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"stop\", ";
-  out << "\"music\": \"" << musicId << "\" }";
-}
-
-void OptionNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"text\": \"" << escapeJsonString(text) << "\", ";
-  out << "\"goto\": \"" << escapeJsonString(gotoLabel) << "\" }";
-}
-
-void ChoiceNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"choice\", ";
-  out << "\"prompt\": \"" << escapeJsonString(prompt) << "\", ";
-  out << "\"options\": [\n";
-  bool first = true;
-  for (const auto &option : options) {
-    if (!first)
-      out << ",\n";
-    option->generateCode(out, indent + 4);
-    first = false;
-  }
-  out << "\n" << std::string(indent + 2, ' ') << "]\n";
-  out << std::string(indent, ' ') << "}";
-}
-
-void LabelNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{\n";
-  out << std::string(indent + 2, ' ') << "\"label\": \"" << name << "\",\n";
-  out << std::string(indent + 2, ' ') << "\"commands\": [\n";
-  bool first = true;
-  for (const auto &stmt : statements) {
-    if (!first)
-      out << ",\n";
-    stmt->generateCode(out, indent + 4);
-    first = false;
-  }
-  out << "\n" << std::string(indent + 2, ' ') << "]\n";
-  out << std::string(indent, ' ') << "}";
-}
-
-void JumpNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{ ";
-  out << "\"command\": \"jump\", ";
-  out << "\"target\": \"" << target << "\" }";
-}
-
-void EndNode::generateCode(std::ostream &out, int indent) const {
-  out << std::string(indent, ' ') << "{\"command\": \"end\"}";
-}
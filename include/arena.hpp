@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bump allocator that owns the nodes of a parsed script. Nodes and the
+// containers inside them draw from one monotonic buffer that is released in
+// a single step when the arena is destroyed. Node destructors never run, so
+// everything a node owns must live in the arena too. An arena is used by one
+// thread at a time.
+class Arena : public std::pmr::monotonic_buffer_resource {
+  static constexpr size_t INITIAL_SIZE = 64 * 1024;
+
+  size_t used = 0;
+  size_t made = 0;
+
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    used += bytes;
+    return monotonic_buffer_resource::do_allocate(bytes, alignment);
+  }
+
+public:
+  Arena() : monotonic_buffer_resource(INITIAL_SIZE) {}
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  std::pmr::memory_resource *memory() { return this; }
+  // Bytes handed out so far, not counting the buffer's unused tail.
+  size_t bytesUsed() const { return used; }
+  // Objects built with make().
+  size_t objectCount() const { return made; }
+
+  // Builds a T in the arena, passing it the arena's memory resource when T
+  // holds containers.
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    void *p = allocate(sizeof(T), alignof(T));
+    ++made;
+    if constexpr (std::is_constructible_v<T, std::pmr::memory_resource *,
+                                          Args...>)
+      return new (p) T(memory(), std::forward<Args>(args)...);
+    else
+      return new (p) T(std::forward<Args>(args)...);
+  }
+};
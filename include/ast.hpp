@@ -1,138 +1,243 @@
 #pragma once
+#include <arena.hpp>
+#include <cstdint>
+#include <interner.hpp>
 #include <memory>
+#include <memory_resource>
 #include <string>
-#include <unordered_map>
-#include <variant>
 #include <vector>
 
-using ParameterValue = std::variant<int, double, std::string>;
-using Parameters = std::unordered_map<std::string, ParameterValue>;
-
+enum class Param : uint8_t { X, Y, SCALE, SIZE, SPEED, COUNT };
+
+// The closed set of optional numeric parameters a node may carry; `present`
+// has bit i set when Param i was given.
+struct Parameters {
+  double values[static_cast<size_t>(Param::COUNT)] = {};
+  uint8_t present = 0;
+
+  bool has(Param p) const { return present & (1u << static_cast<int>(p)); }
+  double get(Param p) const { return values[static_cast<int>(p)]; }
+  void set(Param p, double value) {
+    values[static_cast<int>(p)] = value;
+    present |= 1u << static_cast<int>(p);
+  }
+};
+
+enum class NodeKind : uint8_t {
+  PROGRAM,
+  BACKGROUND,
+  CHARACTER,
+  SCENE,
+  SHOW,
+  HIDE,
+  DIALOGUE,
+  MUSIC,
+  PLAY,
+  STOP,
+  OPTION,
+  CHOICE,
+  LABEL,
+  JUMP,
+  END,
+  IMPORT
+};
+
+// Nodes below ProgramNode are allocated in an Arena and never destroyed one by
+// one; their strings and containers use the arena's memory resource. Every
+// node records its concrete class in `kind`, which passes switch on.
 class ASTNode {
 public:
+  const NodeKind kind;
+
+  explicit ASTNode(NodeKind kind) : kind(kind) {}
   virtual ~ASTNode() = default;
-  virtual void generateCode(std::ostream &out, int indent = 0) const = 0;
 };
 
+// node as a T, or nullptr when it is another kind of node.
+template <typename T> const T *nodeAs(const ASTNode &node) {
+  return node.kind == T::KIND ? static_cast<const T *>(&node) : nullptr;
+}
+
+using NodeList = std::pmr::vector<ASTNode *>;
+
 class ProgramNode : public ASTNode {
 public:
+  static constexpr NodeKind KIND = NodeKind::PROGRAM;
+
   std::string compilerPath;
-  std::vector<std::unique_ptr<ASTNode>> statements;
+  // Arenas holding the nodes, one per parser that contributed statements.
+  // Shared so that IncrementalParser can reuse nodes across parses.
+  std::vector<std::shared_ptr<Arena>> arenas;
+  NodeList statements;
+  // Hash of the contents of every file the program was parsed from.
+  uint64_t sourceHash = 0;
+  // Paths of those files; stdin is not listed.
+  std::vector<std::string> sources;
 
   ProgramNode(std::string compiler_path)
-      : compilerPath(std::move(compiler_path)) {}
-
-  void generateCode(std::ostream &out, int indent) const override;
+      : ASTNode(KIND), compilerPath(std::move(compiler_path)) {}
 };
 
 class MusicNode : public ASTNode {
 public:
-  std::string id;
-  std::string filePath;
-  void generateCode(std::ostream &out, int indent) const override;
+  static constexpr NodeKind KIND = NodeKind::MUSIC;
+
+  Symbol id = 0;
+  std::pmr::string filePath;
+
+  explicit MusicNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), filePath(memory) {}
 };
 
 class PlayNode : public ASTNode {
 public:
-  std::string musicId;
-  void generateCode(std::ostream &out, int indent) const override;
+  static constexpr NodeKind KIND = NodeKind::PLAY;
+
+  Symbol musicId = 0;
+
+  PlayNode() : ASTNode(KIND) {}
 };
 
 class StopNode : public ASTNode {
 public:
-  std::string musicId;
-  void generateCode(std::ostream &out, int indent) const override;
+  static constexpr NodeKind KIND = NodeKind::STOP;
+
+  Symbol musicId = 0;
+
+  StopNode() : ASTNode(KIND) {}
 };
 
 class BackgroundNode : public ASTNode {
 public:
-  std::string name;
-  std::string imagePath;
+  static constexpr NodeKind KIND = NodeKind::BACKGROUND;
+
+  Symbol name = 0;
+  std::pmr::string imagePath;
   Parameters parameters;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  explicit BackgroundNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), imagePath(memory) {}
 };
 
 struct CharacterModeData {
-  std::string name;
-  std::string imagePath;
+  Symbol name = 0;
+  std::pmr::string imagePath;
   Parameters parameters;
+
+  explicit CharacterModeData(std::pmr::memory_resource *memory)
+      : imagePath(memory) {}
 };
 
 class CharacterNode : public ASTNode {
 public:
-  std::string id;
-  std::string displayName;
-  std::vector<std::unique_ptr<CharacterModeData>> modes;
+  static constexpr NodeKind KIND = NodeKind::CHARACTER;
+
+  Symbol id = 0;
+  std::pmr::string displayName;
+  std::pmr::vector<CharacterModeData *> modes;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  explicit CharacterNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), displayName(memory), modes(memory) {}
 };
 
 class ShowNode : public ASTNode {
 public:
-  std::string characterId;
-  std::string mode;
+  static constexpr NodeKind KIND = NodeKind::SHOW;
+
+  Symbol characterId = 0;
+  Symbol mode = 0;
   Parameters parameters;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  ShowNode() : ASTNode(KIND) {}
 };
 
 class HideNode : public ASTNode {
 public:
-  std::string characterId;
+  static constexpr NodeKind KIND = NodeKind::HIDE;
+
+  Symbol characterId = 0;
   Parameters parameters;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  HideNode() : ASTNode(KIND) {}
 };
 
 class DialogueNode : public ASTNode {
 public:
-  std::string speaker;
-  std::string text;
+  static constexpr NodeKind KIND = NodeKind::DIALOGUE;
+
+  Symbol speaker = 0;
+  std::pmr::string text;
   Parameters parameters;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  explicit DialogueNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), text(memory) {}
 };
 
 class SceneNode : public ASTNode {
 public:
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::SCENE;
+
+  Symbol name = 0;
   Parameters parameters;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  SceneNode() : ASTNode(KIND) {}
 };
 
 class OptionNode : public ASTNode {
 public:
-  std::string text;
-  std::string gotoLabel;
+  static constexpr NodeKind KIND = NodeKind::OPTION;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  std::pmr::string text;
+  Symbol gotoLabel = 0;
+
+  explicit OptionNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), text(memory) {}
 };
 
 class ChoiceNode : public ASTNode {
 public:
-  std::string prompt;
-  std::vector<std::unique_ptr<OptionNode>> options;
+  static constexpr NodeKind KIND = NodeKind::CHOICE;
+
+  std::pmr::string prompt;
+  std::pmr::vector<OptionNode *> options;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  explicit ChoiceNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), prompt(memory), options(memory) {}
 };
 
 class LabelNode : public ASTNode {
 public:
-  std::string name;
-  std::vector<std::unique_ptr<ASTNode>> statements;
+  static constexpr NodeKind KIND = NodeKind::LABEL;
 
-  void generateCode(std::ostream &out, int indent) const override;
+  Symbol name = 0;
+  NodeList statements;
+
+  explicit LabelNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), statements(memory) {}
 };
 
 class JumpNode : public ASTNode {
 public:
-  std::string target;
-  void generateCode(std::ostream &out, int indent) const override;
+  static constexpr NodeKind KIND = NodeKind::JUMP;
+
+  Symbol target = 0;
+
+  JumpNode() : ASTNode(KIND) {}
 };
 
 class EndNode : public ASTNode {
 public:
-  void generateCode(std::ostream &out, int indent) const override;
+  static constexpr NodeKind KIND = NodeKind::END;
+
+  EndNode() : ASTNode(KIND) {}
+};
+
+class ImportNode : public ASTNode {
+public:
+  static constexpr NodeKind KIND = NodeKind::IMPORT;
+
+  std::pmr::string path;
+
+  explicit ImportNode(std::pmr::memory_resource *memory)
+      : ASTNode(KIND), path(memory) {}
 };
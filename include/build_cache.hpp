@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A file a compile produces: its name inside a cache entry and where the
+// compile puts it. When `shared` names a file that already holds the same
+// contents, such as the cached engine, the entry hard-links it instead of
+// keeping its own copy.
+struct BuildArtifact {
+  std::string name;
+  std::string path;
+  std::string shared;
+};
+
+// Whole-compile cache under compilerPath/.tmp/cache, one directory per key.
+// The key covers the script and its modules, the compiler binary, the engine
+// source and anything else that changes the output, so an entry never needs
+// to be invalidated. Only the most recently used entries are kept.
+class BuildCache {
+  static constexpr size_t MAX_ENTRIES = 32;
+
+  std::string cacheDir;
+  std::string entry;
+
+public:
+  BuildCache(const std::string &compilerPath, uint64_t key);
+
+  // Copies a stored entry's artifacts to their paths and sets warnings to
+  // the warnings the compile printed. Each file is written under a temporary
+  // name and renamed into place, so a game that has the old story.bin mapped
+  // keeps reading a complete file. Returns false when there is no entry or
+  // one of its files cannot be copied, and then replaces nothing.
+  bool restore(const std::vector<BuildArtifact> &artifacts,
+               std::string &warnings) const;
+  // Stores the artifacts and warnings as this key's entry. The entry appears
+  // complete or not at all, so concurrent compiles may share the cache.
+  void store(const std::vector<BuildArtifact> &artifacts,
+             const std::string &warnings) const;
+};
+
+// Cache key for a program with the given sourceHash, compiled by this
+// compiler with options, a string describing every setting that affects the
+// output.
+uint64_t buildKey(uint64_t sourceHash, const std::string &compilerPath,
+                  const std::string &options);
@@ -0,0 +1,26 @@
+#pragma once
+#include <flat_ast.hpp>
+#include <vector>
+
+// Control-flow graph between the labels of a story. A label flows to the
+// targets of the first jump or choice in it, to nothing after an `end`, and
+// otherwise falls through to the next label, as the engine runs them.
+struct StoryGraph {
+  std::vector<Range> successors; // per label, a range of `edges`
+  std::vector<uint32_t> edges;   // label indices
+};
+
+// The statements of label that can run: up to and including its first jump,
+// choice or end.
+Range liveStmts(const FlatProgram &program, const FlatLabel &label);
+
+StoryGraph buildStoryGraph(const FlatProgram &program);
+
+// Marks the labels reachable from label `entry`.
+std::vector<bool> reachableLabels(const StoryGraph &graph, uint32_t entry);
+
+// Drops the labels that cannot be reached from `start` and returns their
+// names. Without a `start` label nothing is dropped. The statements of the
+// dropped labels stay in `stmts`, and the statements a kept label holds past
+// its liveStmts() may still name them, so writers must emit only liveStmts().
+std::vector<Symbol> removeUnreachableLabels(FlatProgram &program);
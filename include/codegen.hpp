@@ -0,0 +1,24 @@
+#pragma once
+#include <flat_ast.hpp>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Source of the game engine, which loads compilerPath/.tmp/story.bin unless
+// given another story on its command line.
+std::string engineSource(const std::string &compilerPath);
+
+// The #include lines the engine source starts with.
+std::string_view engineIncludes();
+
+// Writes the story as JSON in one pass over the flat arrays: assets first,
+// then every label in order. Only written on request, for debugging.
+void generateStory(const FlatProgram &program, std::ostream &out);
+
+// Writes story.bin, the binary form of the story the engine loads; see
+// story_format.hpp. out must be opened in binary mode.
+void generateBytecode(const FlatProgram &program, std::ostream &out);
+
+// Writes a C++ source file that defines the story.bin image `bytecode` as
+// constant data, for linking into a game built with --embed.
+void generateStorySource(std::string_view bytecode, std::ostream &out);
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+enum class EngineBuild {
+  // A complete game that loads story.bin at run time.
+  PLAYER,
+  // An object file whose story is linked in by linkEmbeddedGame().
+  EMBEDDED
+};
+
+// Returns the path of the compiled game engine, building it first if needed.
+// The engine's source only changes with the compiler, so each build is kept
+// in compilerPath/.tmp/engine under the hash of its source and compile
+// command, and later story compiles reuse it instead of running g++ again.
+// Only the most recently used builds are kept.
+std::string buildEngine(const std::string &compilerPath,
+                        EngineBuild build = EngineBuild::PLAYER);
+
+// Builds the game at output from the EMBEDDED engine and storySource, a file
+// written by generateStorySource(). Only the story data is compiled.
+void linkEmbeddedGame(const std::string &compilerPath,
+                      const std::string &storySource,
+                      const std::string &output);
@@ -0,0 +1,152 @@
+#pragma once
+#include <ast.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Struct-of-arrays form of a parsed story. Every node kind lives in its own
+// dense array and refers to other nodes by 32-bit index; the statements of a
+// label are a contiguous range of `stmts`. Strings are slices of one shared
+// buffer. Statements outside labels never run and are not kept.
+//
+// flatten() builds it from the tree, switching once on each node's kind. The
+// passes that run after it read statements by their StmtKind and index and
+// never look at tree nodes.
+
+// Index into the array of T.
+template <typename T> struct Id {
+  uint32_t value = 0;
+};
+
+// [first, first + count) of some array.
+struct Range {
+  uint32_t first = 0;
+  uint32_t count = 0;
+  uint32_t end() const { return first + count; }
+};
+
+struct StrRef {
+  uint32_t offset = 0;
+  uint32_t size = 0;
+};
+
+// Index into FlatProgram::params; 0 means the node has no parameters.
+using ParamsId = Id<Parameters>;
+
+struct FlatBackground {
+  Symbol name;
+  StrRef imagePath;
+};
+
+struct FlatMusic {
+  Symbol id;
+  StrRef filePath;
+};
+
+struct FlatMode {
+  Symbol name;
+  StrRef imagePath;
+  ParamsId params;
+};
+
+struct FlatCharacter {
+  Symbol id;
+  StrRef displayName;
+  Range modes;
+};
+
+struct FlatScene {
+  Symbol background;
+  ParamsId params;
+};
+
+struct FlatShow {
+  Symbol character;
+  Symbol mode;
+  ParamsId params;
+};
+
+struct FlatHide {
+  Symbol character;
+  ParamsId params;
+};
+
+struct FlatDialogue {
+  Symbol speaker;
+  StrRef text;
+  ParamsId params;
+};
+
+struct FlatAudio {
+  Symbol music;
+};
+
+struct FlatOption {
+  StrRef text;
+  Symbol target;
+};
+
+struct FlatChoice {
+  StrRef prompt;
+  Range options;
+};
+
+struct FlatJump {
+  Symbol target;
+};
+
+enum class StmtKind : uint8_t {
+  SCENE,
+  SHOW,
+  HIDE,
+  DIALOGUE,
+  PLAY,
+  STOP,
+  CHOICE,
+  JUMP,
+  END
+};
+
+// A label statement: its kind and its index in that kind's array (unused for
+// END).
+struct Stmt {
+  StmtKind kind;
+  uint32_t index;
+};
+
+struct FlatLabel {
+  Symbol name;
+  Range stmts;
+};
+
+struct FlatProgram {
+  std::vector<FlatBackground> backgrounds;
+  std::vector<FlatMusic> music;
+  std::vector<FlatCharacter> characters;
+  std::vector<FlatMode> modes;
+  std::vector<FlatLabel> labels;
+  std::vector<Stmt> stmts;
+  std::vector<FlatScene> scenes;
+  std::vector<FlatShow> shows;
+  std::vector<FlatHide> hides;
+  std::vector<FlatDialogue> dialogues;
+  std::vector<FlatAudio> plays;
+  std::vector<FlatAudio> stops;
+  std::vector<FlatChoice> choices;
+  std::vector<FlatOption> options;
+  std::vector<FlatJump> jumps;
+  std::vector<Parameters> params{Parameters{}};
+  std::string strings;
+
+  std::string_view str(StrRef s) const {
+    return std::string_view(strings).substr(s.offset, s.size);
+  }
+  const Parameters &parameters(ParamsId id) const { return params[id.value]; }
+
+  // Bytes held by the arrays and the string buffer.
+  size_t bytes() const;
+  void shrinkToFit();
+};
+
+FlatProgram flatten(const ProgramNode &program);
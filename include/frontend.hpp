@@ -0,0 +1,51 @@
+#pragma once
+#include <ast.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Lexes and parses the script at path. Inputs large enough to benefit are
+// split at top-level `label` lines: asset definitions before the first label
+// are parsed first, then the label blocks are parsed on up to `jobs` worker
+// threads and merged in source order before the jump targets are checked.
+// Scripts that `import` other files are handed to parseModules().
+std::unique_ptr<ProgramNode> parseScript(const char *path,
+                                         const std::string &compilerPath,
+                                         unsigned jobs);
+
+// Parses the same script again after each edit, for --watch. The labels are
+// grouped into segments that end where a label's line hashes to a multiple of
+// SEGMENT_LABELS, so an edit moves no boundary but its own. A segment whose
+// text and asset prelude are unchanged since the previous parse reuses its
+// nodes, and only the segments an edit touched are lexed and parsed again.
+// Files are read rather than mapped, so a save that truncates the script
+// mid-parse cannot fault. Scripts with imports go through parseModules(),
+// whose module cache does the same per file.
+class IncrementalParser {
+  static constexpr uint64_t SEGMENT_LABELS = 32;
+
+  struct Segment {
+    size_t size = 0;
+    std::shared_ptr<Arena> arena;
+    NodeList statements;
+    // Listed rather than kept as a SymbolSet, whose merge would walk every
+    // symbol once per segment.
+    std::vector<Symbol> labels;
+    std::vector<Symbol> jumpTargets;
+  };
+
+  std::string compilerPath;
+  unsigned jobs;
+  uint64_t preludeHash = 0;
+  // Segments of the previous parse by the hash of their text.
+  std::unordered_map<uint64_t, std::shared_ptr<const Segment>> segments;
+
+public:
+  IncrementalParser(std::string compilerPath, unsigned jobs)
+      : compilerPath(std::move(compilerPath)), jobs(jobs) {}
+
+  std::unique_ptr<ProgramNode> parse(const char *path);
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// 64-bit FNV-1a. Used to key on-disk caches by content, not for security.
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+constexpr uint64_t fnv1a(std::string_view data, uint64_t hash = FNV_OFFSET) {
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// Hash of the running compiler binary, computed once. Mixed into cache keys
+// so that entries written by a different build of the compiler are ignored.
+uint64_t compilerHash();
@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dense integer ID of an interned identifier. Symbol 0 is the empty string.
+// The interner is shared by the parallel front end's workers.
+using Symbol = uint32_t;
+
+class StringInterner {
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char *block = nullptr;
+  size_t blockUsed = BLOCK_SIZE;
+  std::vector<std::string_view> names;
+  std::unordered_map<std::string_view, Symbol> ids;
+  mutable std::shared_mutex mutex;
+
+  StringInterner();
+  std::string_view store(std::string_view s);
+
+public:
+  static StringInterner &getInstance() {
+    static StringInterner instance;
+    return instance;
+  }
+
+  Symbol intern(std::string_view s);
+  std::string_view str(Symbol s) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names[s];
+  }
+  size_t size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+  }
+};
+
+inline Symbol intern(std::string_view s) {
+  return StringInterner::getInstance().intern(s);
+}
+
+inline std::string_view nameOf(Symbol s) {
+  return StringInterner::getInstance().str(s);
+}
+
+class SymbolSet {
+  std::vector<bool> bits;
+
+public:
+  bool count(Symbol s) const { return s < bits.size() && bits[s]; }
+  void insert(Symbol s) {
+    if (s >= bits.size())
+      bits.resize(std::max<size_t>(s + 1, bits.size() * 2));
+    bits[s] = true;
+  }
+  void insertAll(const SymbolSet &other) {
+    if (other.bits.size() > bits.size())
+      bits.resize(other.bits.size());
+    for (size_t i = 0; i < other.bits.size(); ++i) {
+      if (other.bits[i])
+        bits[i] = true;
+    }
+  }
+};
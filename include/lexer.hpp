@@ -1,28 +1,41 @@
 #pragma once
 
+#include <cstddef>
 #include <deque>
+#include <memory>
+#include <source.hpp>
+#include <string>
+#include <string_view>
 #include <token.hpp>
 
+// Token values are slices of the script text and stay valid for the lifetime
+// of the Lexer. Strings containing escapes are unescaped into ownedLexemes.
 class Lexer {
-  static constexpr int BUFFER_SIZE = 4096;
-  std::deque<Token> bufferToken;
+  std::deque<std::string> ownedLexemes;
 
-  char buffer[BUFFER_SIZE];
-  int fd;
-  int bufferPos = 0;
-  int bufferLen = 0;
+  std::unique_ptr<SourceFile> source;
+  const char *pos = nullptr;
+  const char *end = nullptr;
   int line = 1;
 
   char currentChar = 0;
   bool endOfFile = false;
+  size_t tokensRead = 0;
 
   void advance();
+  void skipTo(const char *p) {
+    pos = p;
+    advance();
+  }
+  const char *mark() const { return endOfFile ? end : pos - 1; }
   Token realNextToken();
 
 public:
-  explicit Lexer(const char* path);
-  ~Lexer();
+  explicit Lexer(const char *path);
+  // Lexes text owned by the caller, numbering lines from firstLine.
+  explicit Lexer(std::string_view text, int firstLine = 1);
 
   Token nextToken();
-  Token peekToken(size_t n = 1);
+  // Tokens handed to the parser so far.
+  size_t tokenCount() const { return tokensRead; }
 };
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// The on-disk caches under compilerPath/.tmp never invalidate an entry, since
+// their keys cover everything that changes it, so they are bounded instead:
+// each use refreshes an entry's mtime and the oldest entries are removed.
+
+// Marks the file or directory at path as just used.
+void markUsed(const std::string &path);
+
+// Removes the least recently used entries of dir beyond keep. Names holding
+// ".tmp" are entries still being written by some compile and are left alone.
+void evictLeastRecentlyUsed(const std::string &dir, size_t keep);
@@ -0,0 +1,20 @@
+#pragma once
+#include <ast.hpp>
+#include <memory>
+#include <source.hpp>
+#include <string>
+#include <string_view>
+
+// Parses the script at path, whose contents are text, together with every
+// module it imports directly or indirectly. Import paths are relative to the
+// importing file. Modules are lexed and parsed independently, up to `jobs` at
+// a time, and each AST is cached under compilerPath/.tmp/modules keyed by the
+// hash of the module's contents and of the compiler binary, so only edited
+// modules are parsed again. The least recently used entries are evicted.
+// A module's statements take the place of its first import; later imports of
+// the same file are ignored. References to assets and labels are checked once
+// every module is loaded. Imported files are opened with `mode`.
+std::unique_ptr<ProgramNode>
+parseModules(const char *path, std::string_view text,
+             const std::string &compilerPath, unsigned jobs,
+             SourceFile::Mode mode = SourceFile::Mode::MAP);
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+// Manipulators for OutputBuffer: n spaces, and text with JSON escapes for
+// quotes, backslashes and the common control characters.
+struct Indent {
+  size_t width;
+};
+struct Escaped {
+  std::string_view text;
+};
+
+// Buffered writer for generated text. Output is collected in one large
+// buffer and handed to the stream in big blocks, so code generation is not
+// bound by per-call iostream overhead. Writes past the buffer flush it; the
+// destructor flushes whatever is left.
+class OutputBuffer {
+  static constexpr size_t CAPACITY = 1 << 20;
+  static constexpr size_t MAX_INDENT = 64;
+
+  std::ostream &out;
+  std::unique_ptr<char[]> buffer;
+  size_t used = 0;
+
+  void reserve(size_t n) {
+    if (used + n > CAPACITY)
+      flush();
+  }
+
+public:
+  explicit OutputBuffer(std::ostream &out)
+      : out(out), buffer(new char[CAPACITY]) {}
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer &operator=(const OutputBuffer &) = delete;
+  ~OutputBuffer() { flush(); }
+
+  void flush();
+
+  OutputBuffer &operator<<(std::string_view s) {
+    if (s.size() > CAPACITY / 2) {
+      flush();
+      out.write(s.data(), s.size());
+      return *this;
+    }
+    reserve(s.size());
+    std::memcpy(buffer.get() + used, s.data(), s.size());
+    used += s.size();
+    return *this;
+  }
+  OutputBuffer &operator<<(char c) {
+    reserve(1);
+    buffer[used++] = c;
+    return *this;
+  }
+  OutputBuffer &operator<<(uint32_t value);
+  // Formats like an ostream with default flags, i.e. printf's %g.
+  OutputBuffer &operator<<(double value);
+
+  OutputBuffer &operator<<(Indent indent) {
+    static constexpr char spaces[MAX_INDENT + 1] =
+        "                                                                ";
+    size_t n = indent.width;
+    for (; n > MAX_INDENT; n -= MAX_INDENT)
+      *this << std::string_view(spaces, MAX_INDENT);
+    return *this << std::string_view(spaces, n);
+  }
+  // Runs that need no escaping are copied in one step.
+  OutputBuffer &operator<<(Escaped escaped);
+};
@@ -1,79 +1,98 @@
 #pragma once
+#include <array>
 #include <ast.hpp>
+#include <interner.hpp>
 #include <lexer.hpp>
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 enum ParameterMode { IMAGE, DIALOGUE };
 
+// Where a statement may appear, as a bitmask.
+enum StatementScope : uint8_t { TOP_LEVEL = 1 << 0, IN_LABEL = 1 << 1 };
+
+enum class RefKind : uint8_t { BACKGROUND, CHARACTER, MODE, MUSIC };
+
+// A use of an asset that is not defined in the module being parsed. MODE
+// references name the character in `name` and the mode in `mode`.
+struct SymbolRef {
+  RefKind kind;
+  Symbol name;
+  Symbol mode;
+  int line;
+};
+
 struct SymbolTable {
-  std::unordered_set<std::string> backgrounds;
-  std::unordered_map<std::string, std::unordered_set<std::string>> characters;
-  std::unordered_set<std::string> music;
-  std::unordered_set<std::string> labels;
-  std::unordered_set<std::string> jumpTargets;
+  SymbolSet backgrounds;
+  std::unordered_map<Symbol, SymbolSet> characters;
+  SymbolSet music;
+  SymbolSet labels;
+  std::vector<Symbol> jumpTargets;
+  std::vector<SymbolRef> unresolved;
 };
 
+void checkJumpTargets(const SymbolTable &symbols);
+
 class Parser {
 public:
   Parser(Lexer &lexer, std::string compilerPath);
 
   std::unique_ptr<ProgramNode> parseProgram();
+  void parseStatements(NodeList &statements);
+
+  SymbolTable &symbolTable() { return symbols; }
+  // Records uses of undefined assets in symbolTable().unresolved instead of
+  // failing, so a module can be parsed before the modules it relies on.
+  void deferUndefinedReferences() { deferChecks = true; }
+  // Hands over the arena holding the nodes parsed so far; they stay valid for
+  // as long as the returned arena lives.
+  std::unique_ptr<Arena> releaseArena() { return std::move(arena); }
 
 private:
+  // Parser for the statement introduced by a token, and the scopes that
+  // accept it. Tokens that cannot start a statement have no parser.
+  struct StatementRule {
+    ASTNode *(Parser::*parse)() = nullptr;
+    uint8_t scopes = 0;
+  };
+  static const std::array<StatementRule, TOKEN_TYPE_COUNT> statementRules;
+
   Lexer &lexer;
   Token current;
 
   std::string compilerPath;
   SymbolTable symbols;
+  bool deferChecks = false;
+  std::unique_ptr<Arena> arena = std::make_unique<Arena>();
+  Symbol currentLabel = 0;
 
   void advance();
   void expect(TokenType type, const std::string &msg);
-  void parseStatement();
-
-  std::unique_ptr<MusicNode> parseMusic();
-  std::unique_ptr<PlayNode> parsePlay();
-  std::unique_ptr<StopNode> parseStop();
-  std::unique_ptr<BackgroundNode> parseBackground();
-  std::unique_ptr<CharacterNode> parseDefine();
-  std::unique_ptr<SceneNode> parseScene();
-  std::unique_ptr<ShowNode> parseShow();
-  std::unique_ptr<HideNode> parseHide();
-  std::unique_ptr<DialogueNode> parseDialogue();
-  std::unique_ptr<ChoiceNode> parseChoice();
-  std::unique_ptr<LabelNode> parseLabel();
-  std::unique_ptr<CharacterModeData> parseMode();
-  std::unique_ptr<JumpNode> parseJump();
-  std::unique_ptr<EndNode> parseEnd();
-
-  void
-  parseParameters(ParameterMode mode,
-                  std::unordered_map<std::string, ParameterValue> &parametes);
-  void
-  parseParameter(ParameterMode mode,
-                 std::unordered_map<std::string, ParameterValue> &parameters);
-
-  bool isMusic() { return current.type == TokenType::MUSIC; }
-  bool isPlay() { return current.type == TokenType::PLAY; }
-  bool isStop() { return current.type == TokenType::STOP; }
-  bool isBackground() { return current.type == TokenType::BACKGROUND; }
-  bool isDefine() { return current.type == TokenType::DEFINE; }
-  bool isScene() { return current.type == TokenType::SCENE; }
-  bool isShow() { return current.type == TokenType::SHOW; }
-  bool isHide() { return current.type == TokenType::HIDE; }
-  bool isChoice() { return current.type == TokenType::CHOICE; }
-  bool isLabel() { return current.type == TokenType::LABEL; }
-  bool isJump() { return current.type == TokenType::JUMP; }
-  bool isEnd() { return current.type == TokenType::END; }
-  bool isDialogue() {
-    if (current.type == TokenType::STRING)
-      return true;
-    if (current.type == TokenType::IDENTIFIER) {
-      Token next = lexer.peekToken(1);
-      return next.type == TokenType::STRING;
-    }
-    return false;
+  ASTNode *parseStatement(StatementScope scope);
+  template <typename T, T *(Parser::*Parse)()> ASTNode *parseAs() {
+    return (this->*Parse)();
   }
+
+  MusicNode *parseMusic();
+  PlayNode *parsePlay();
+  StopNode *parseStop();
+  BackgroundNode *parseBackground();
+  CharacterNode *parseDefine();
+  SceneNode *parseScene();
+  ShowNode *parseShow();
+  HideNode *parseHide();
+  DialogueNode *parseDialogue();
+  ChoiceNode *parseChoice();
+  LabelNode *parseLabel();
+  CharacterModeData *parseMode();
+  JumpNode *parseJump();
+  EndNode *parseEnd();
+  ImportNode *parseImport();
+
+  bool defer(RefKind kind, Symbol name, Symbol mode = 0);
+
+  void parseParameters(ParameterMode mode, Parameters &parameters);
+  void parseParameter(ParameterMode mode, Parameters &parameters);
 };
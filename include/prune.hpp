@@ -0,0 +1,9 @@
+#pragma once
+#include <flat_ast.hpp>
+
+// Drops the backgrounds, music and character modes that no live statement of
+// a remaining label uses, so the engine only loads what the story can show or
+// play. Run it after removeUnreachableLabels(). Characters are kept while
+// they speak, are shown or are hidden, since the engine uses their display
+// name; only their shown modes survive.
+void pruneUnusedAssets(FlatProgram &program);
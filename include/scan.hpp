@@ -0,0 +1,15 @@
+#pragma once
+
+// Bulk scanners used by the lexer for the long runs of a script. Each one has
+// AVX2, SSE2 and scalar versions; the widest one the CPU supports is picked
+// on first use.
+
+// First '"', '\\' or '\n' in [p, end), or end.
+const char *scanString(const char *p, const char *end);
+
+// First '\n' in [p, end), or end.
+const char *scanLine(const char *p, const char *end);
+
+// First non-whitespace character in [p, end), or end. Adds the newlines
+// skipped over to lines.
+const char *skipSpace(const char *p, const char *end, int &lines);
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Script contents, mapped read-only when the input is a regular file and read
+// through a buffered read() loop otherwise (pipes, "-" for stdin).
+class SourceFile {
+public:
+  // READ always copies the file with read(), for files that an editor may
+  // truncate while they are still in use.
+  enum class Mode { MAP, READ };
+
+private:
+  static constexpr int BUFFER_SIZE = 4096;
+
+  int fd = -1;
+  char *mapped = nullptr;
+  size_t mappedLen = 0;
+  std::string buffer;
+
+  void readAll();
+
+public:
+  explicit SourceFile(const char *path, Mode mode = Mode::MAP);
+  ~SourceFile();
+
+  SourceFile(const SourceFile &) = delete;
+  SourceFile &operator=(const SourceFile &) = delete;
+
+  std::string_view text() const;
+  bool isMapped() const { return mapped != nullptr; }
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+
+// Layout of story.bin, the compiled story the engine maps into memory. The
+// file is a StoryHeader followed by these arrays, back to back and in this
+// order, sized by the header's counts:
+//
+//   StoryString[strings]  StoryAsset[backgrounds]  StoryAsset[music]
+//   StoryCharacter[characters]  StoryMode[modes]  StoryCommand[commands]
+//   StoryOption[options]  char[textBytes]
+//
+// Every field is 4 bytes wide, so each array is aligned wherever it starts.
+// Names, paths and text are ids into the string table, which is
+// deduplicated; an asset and the commands that use it share the name's id.
+// The engine template in codegen.cpp mirrors these definitions, so any change
+// here must bump STORY_VERSION and be made there too.
+
+constexpr char STORY_MAGIC[4] = {'S', 'S', 'T', 'B'};
+constexpr uint32_t STORY_VERSION = 1;
+// Header entry when the story has no `start` label.
+constexpr uint32_t STORY_NO_ENTRY = UINT32_MAX;
+
+struct StoryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t strings;
+  uint32_t backgrounds;
+  uint32_t music;
+  uint32_t characters;
+  uint32_t modes;
+  uint32_t commands;
+  uint32_t options;
+  uint32_t textBytes;
+  // Command index of the `start` label.
+  uint32_t entry;
+};
+
+// [offset, offset + size) of the text block.
+struct StoryString {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct StoryAsset {
+  uint32_t name;
+  uint32_t path;
+};
+
+struct StoryCharacter {
+  uint32_t name;
+  uint32_t displayName;
+  // Range of the modes array.
+  uint32_t firstMode;
+  uint32_t modeCount;
+};
+
+struct StoryMode {
+  uint32_t name;
+  uint32_t path;
+  float scaleX;
+  float scaleY;
+};
+
+// Stored in story.bin, so the values are fixed. The compiler casts each
+// StmtKind to the op of the same name; codegen.cpp checks that they match.
+enum class StoryOp : uint32_t {
+  SCENE = 0,
+  SHOW = 1,
+  HIDE = 2,
+  DIALOGUE = 3,
+  PLAY = 4,
+  STOP = 5,
+  CHOICE = 6,
+  JUMP = 7,
+  END = 8
+};
+
+// One fixed-width record per command. Operands by op:
+//   SCENE     a = background
+//   SHOW      a = character, b = mode, x/y = position
+//   HIDE      a = character
+//   DIALOGUE  a = speaker, b = text, x = speed
+//   PLAY/STOP a = music
+//   CHOICE    a = prompt, b = first option, c = option count
+//   JUMP      a = target command
+struct StoryCommand {
+  StoryOp op;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  float x;
+  float y;
+};
+
+struct StoryOption {
+  uint32_t text;
+  // Command index the option jumps to.
+  uint32_t target;
+};
+
+static_assert(sizeof(StoryHeader) == 44 && sizeof(StoryCommand) == 24,
+              "story.bin records must not contain padding");
@@ -1,6 +1,11 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <interner.hpp>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 
 enum class State { START, IDENTIFIER, NUMBER, STRING, ERROR };
 
@@ -31,50 +36,150 @@ enum class TokenType {
   RBRACKET,
   END_OF_FILE,
   END,
+  IMPORT,
   UNKNOWN
 };
 
 struct Token {
   TokenType type;
-  std::string value;
+  std::string_view value;
   int line;
+  Symbol symbol;
 
-  Token(TokenType t, const std::string &v, int l)
-      : type(t), value(v), line(l) {}
+  Token() : type(TokenType::UNKNOWN), line(0), symbol(0) {}
+  Token(TokenType t, std::string_view v, int l, Symbol s = 0)
+      : type(t), value(v), line(l), symbol(s) {}
 };
 
-namespace std {
-template <> struct hash<TokenType> {
-  std::size_t operator()(const TokenType &t) const {
-    return std::hash<int>()(static_cast<int>(t));
-  }
+struct TokenInfo {
+  TokenType type;
+  std::string_view name;
+  std::string_view keyword;
 };
-} // namespace std
-
-const std::unordered_map<TokenType, std::string> tokenStr = {
-    {TokenType::BACKGROUND, "BACKGROUND"},
-    {TokenType::COMMENT, "COMMENT"},
-    {TokenType::DEFINE, "DEFINE"},
-    {TokenType::SHOW, "SHOW"},
-    {TokenType::SCENE, "SCENE"},
-    {TokenType::MUSIC, "MUSIC"},
-    {TokenType::PLAY, "PLAY"},
-    {TokenType::STOP, "STOP"},
-    {TokenType::CHOICE, "CHOICE"},
-    {TokenType::OPTION, "OPTION"},
-    {TokenType::LABEL, "LABEL"},
-    {TokenType::JUMP, "JUMP"},
-    {TokenType::ARROW, "ARROW"},
-    {TokenType::IDENTIFIER, "IDENTIFIER"},
-    {TokenType::STRING, "STRING"},
-    {TokenType::INT, "INT"},
-    {TokenType::FLOAT, "FLOAT"},
-    {TokenType::COLON, "COLON"},
-    {TokenType::COMMA, "COMMA"},
-    {TokenType::LPAREN, "LPAREN"},
-    {TokenType::RPAREN, "RPAREN"},
-    {TokenType::LBRACKET, "LBRACKET"},
-    {TokenType::RBRACKET, "RBRACKET"},
-    {TokenType::UNKNOWN, "UNKNOWN"},
-    {TokenType::END, "END"},
-    {TokenType::END_OF_FILE, "EOF"}};
+
+// Indexed by TokenType. Entries with a keyword spelling are recognised by the
+// lexer; adding a keyword only takes a new TokenType and a row here.
+constexpr TokenInfo tokenTable[] = {
+    {TokenType::BACKGROUND, "BACKGROUND", "background"},
+    {TokenType::COMMENT, "COMMENT", ""},
+    {TokenType::DEFINE, "DEFINE", "define"},
+    {TokenType::SHOW, "SHOW", "show"},
+    {TokenType::HIDE, "HIDE", "hide"},
+    {TokenType::SCENE, "SCENE", "scene"},
+    {TokenType::MUSIC, "MUSIC", "music"},
+    {TokenType::PLAY, "PLAY", "play"},
+    {TokenType::STOP, "STOP", "stop"},
+    {TokenType::CHOICE, "CHOICE", "choice"},
+    {TokenType::OPTION, "OPTION", "option"},
+    {TokenType::LABEL, "LABEL", "label"},
+    {TokenType::JUMP, "JUMP", "jump"},
+    {TokenType::ARROW, "ARROW", ""},
+    {TokenType::IDENTIFIER, "IDENTIFIER", ""},
+    {TokenType::STRING, "STRING", ""},
+    {TokenType::FLOAT, "FLOAT", ""},
+    {TokenType::INT, "INT", ""},
+    {TokenType::COLON, "COLON", ""},
+    {TokenType::COMMA, "COMMA", ""},
+    {TokenType::LPAREN, "LPAREN", ""},
+    {TokenType::RPAREN, "RPAREN", ""},
+    {TokenType::LBRACKET, "LBRACKET", ""},
+    {TokenType::RBRACKET, "RBRACKET", ""},
+    {TokenType::END_OF_FILE, "EOF", ""},
+    {TokenType::END, "END", "end"},
+    {TokenType::IMPORT, "IMPORT", "import"},
+    {TokenType::UNKNOWN, "UNKNOWN", ""}};
+
+constexpr size_t TOKEN_TYPE_COUNT = sizeof(tokenTable) / sizeof(tokenTable[0]);
+
+constexpr bool tokenTableInOrder() {
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; ++i) {
+    if (static_cast<size_t>(tokenTable[i].type) != i)
+      return false;
+  }
+  return TOKEN_TYPE_COUNT == static_cast<size_t>(TokenType::UNKNOWN) + 1;
+}
+static_assert(tokenTableInOrder(), "tokenTable must follow TokenType order");
+
+constexpr std::string_view tokenStr(TokenType type) {
+  return tokenTable[static_cast<size_t>(type)].name;
+}
+
+// Perfect hash over the keyword spellings: the seed is searched at compile
+// time so that every keyword lands in its own slot.
+namespace keywords {
+
+constexpr size_t SLOTS = 32;
+
+constexpr size_t hash(std::string_view s, unsigned seed) {
+  return (static_cast<unsigned char>(s.front()) * seed +
+          static_cast<unsigned char>(s.back()) + s.size() * 3) %
+         SLOTS;
+}
+
+constexpr bool isPerfect(unsigned seed) {
+  std::array<bool, SLOTS> used{};
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; ++i) {
+    std::string_view kw = tokenTable[i].keyword;
+    if (kw.empty())
+      continue;
+    size_t h = hash(kw, seed);
+    if (used[h])
+      return false;
+    used[h] = true;
+  }
+  return true;
+}
+
+constexpr unsigned findSeed() {
+  for (unsigned seed = 1; seed < 4096; ++seed) {
+    if (isPerfect(seed))
+      return seed;
+  }
+  return 0;
+}
+
+constexpr std::array<int8_t, SLOTS> buildSlots(unsigned seed) {
+  std::array<int8_t, SLOTS> slots{};
+  for (auto &slot : slots)
+    slot = -1;
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; ++i) {
+    if (!tokenTable[i].keyword.empty())
+      slots[hash(tokenTable[i].keyword, seed)] = static_cast<int8_t>(i);
+  }
+  return slots;
+}
+
+constexpr unsigned SEED = findSeed();
+static_assert(SEED != 0, "no perfect hash seed for the keyword table");
+constexpr std::array<int8_t, SLOTS> TABLE = buildSlots(SEED);
+
+constexpr std::pair<size_t, size_t> lengthRange() {
+  size_t lo = SIZE_MAX, hi = 0;
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; ++i) {
+    size_t len = tokenTable[i].keyword.size();
+    if (len == 0)
+      continue;
+    lo = len < lo ? len : lo;
+    hi = len > hi ? len : hi;
+  }
+  return {lo, hi};
+}
+
+constexpr size_t MIN_LENGTH = lengthRange().first;
+constexpr size_t MAX_LENGTH = lengthRange().second;
+
+} // namespace keywords
+
+constexpr TokenType keywordType(std::string_view lexeme) {
+  if (lexeme.size() < keywords::MIN_LENGTH ||
+      lexeme.size() > keywords::MAX_LENGTH)
+    return TokenType::IDENTIFIER;
+  int8_t i = keywords::TABLE[keywords::hash(lexeme, keywords::SEED)];
+  if (i >= 0 && tokenTable[i].keyword == lexeme)
+    return tokenTable[i].type;
+  return TokenType::IDENTIFIER;
+}
+
+static_assert(keywordType("background") == TokenType::BACKGROUND);
+static_assert(keywordType("end") == TokenType::END);
+static_assert(keywordType("ending") == TokenType::IDENTIFIER);
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Records compiler phases as Chrome trace events, viewable in
+// chrome://tracing or Perfetto. Tracing is off until start() is called, and
+// while it is off a span or counter costs one load. Spans may be opened from
+// any thread.
+class Tracer {
+  struct Event {
+    const char *name;
+    char phase;
+    int64_t time;
+    int64_t duration;
+    uint32_t thread;
+    int64_t value;
+    std::string detail;
+  };
+
+  std::atomic<bool> enabled{false};
+  std::chrono::steady_clock::time_point epoch;
+  std::string path;
+  std::vector<Event> events;
+  std::map<std::string, int64_t> totals;
+  std::mutex mutex;
+
+  Tracer() = default;
+
+public:
+  static Tracer &getInstance() {
+    static Tracer instance;
+    return instance;
+  }
+
+  bool active() const { return enabled.load(std::memory_order_relaxed); }
+  // Microseconds since start().
+  int64_t now() const;
+
+  void start(const std::string &file);
+  // Writes the recorded events to the file given to start(). Throws if the
+  // file cannot be written.
+  void finish();
+
+  void span(const char *name, int64_t begin, std::string detail);
+  // Adds amount to a running counter and records its new total.
+  void add(const char *counter, int64_t amount);
+};
+
+// Records a span covering the lifetime of the object. detail, if given, is
+// shown with the span, e.g. the module being parsed.
+class TraceSpan {
+  const char *name;
+  std::string detail;
+  int64_t begin = 0;
+
+public:
+  explicit TraceSpan(const char *name, std::string detail = {})
+      : name(name), detail(std::move(detail)) {
+    if (Tracer::getInstance().active())
+      begin = Tracer::getInstance().now();
+  }
+  ~TraceSpan() {
+    if (Tracer::getInstance().active())
+      Tracer::getInstance().span(name, begin, std::move(detail));
+  }
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+};
+
+inline void traceCount(const char *counter, int64_t amount) {
+  if (Tracer::getInstance().active())
+    Tracer::getInstance().add(counter, amount);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Waits for edits to a set of files with inotify. The directories holding
+// the files are watched rather than the files themselves, so a file that an
+// editor saves by renaming a new copy over it is still seen.
+class FileWatcher {
+  // Time a save has to be quiet before wait() returns, so that the several
+  // events one save produces trigger a single rebuild.
+  static constexpr int SETTLE_MS = 30;
+
+  int fd = -1;
+  // Watched directory by watch descriptor.
+  std::unordered_map<int, std::string> dirs;
+  // Absolute paths of the watched files.
+  std::unordered_set<std::string> files;
+
+  bool matches(const char *events, size_t size) const;
+
+public:
+  FileWatcher();
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  // Replaces the watched files with paths.
+  void watch(const std::vector<std::string> &paths);
+  // Blocks until a watched file is written or replaced. Returns false when a
+  // signal interrupts the wait.
+  bool wait();
+};
@@ -0,0 +1,101 @@
+#include <build_cache.hpp>
+#include <codegen.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <hash.hpp>
+#include <lru.hpp>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+BuildCache::BuildCache(const std::string &compilerPath, uint64_t key)
+    : cacheDir(compilerPath + "/.tmp/cache") {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(key));
+  entry = cacheDir + "/" + name;
+}
+
+namespace {
+
+constexpr const char *WARNINGS = "advertencias.txt";
+
+} // namespace
+
+bool BuildCache::restore(const std::vector<BuildArtifact> &artifacts,
+                         std::string &warnings) const {
+  std::error_code ec;
+  if (!fs::is_directory(entry, ec))
+    return false;
+  std::ifstream in(entry + "/" + WARNINGS);
+  std::ostringstream text;
+  text << in.rdbuf();
+
+  // Another compile may evict the entry meanwhile, so every artifact is
+  // copied before any of them replaces the previous output.
+  std::vector<std::string> copies;
+  for (const BuildArtifact &artifact : artifacts) {
+    copies.push_back(artifact.path + ".tmp");
+    fs::copy_file(entry + "/" + artifact.name, copies.back(),
+                  fs::copy_options::overwrite_existing, ec);
+    if (ec)
+      break;
+  }
+  for (size_t i = 0; !ec && i < artifacts.size(); ++i)
+    fs::rename(copies[i], artifacts[i].path, ec);
+  if (ec) {
+    for (const std::string &copy : copies)
+      fs::remove(copy, ec);
+    // Dropped so that the rebuild can store a complete entry in its place.
+    fs::remove_all(entry, ec);
+    return false;
+  }
+  warnings = text.str();
+  markUsed(entry);
+  return true;
+}
+
+void BuildCache::store(const std::vector<BuildArtifact> &artifacts,
+                       const std::string &warnings) const {
+  std::string tmp = entry + ".tmp" + std::to_string(getpid()) + "." +
+                    std::to_string(std::hash<std::thread::id>{}(
+                        std::this_thread::get_id()));
+  std::error_code ec;
+  fs::create_directories(tmp, ec);
+  if (ec)
+    return;
+  for (const BuildArtifact &artifact : artifacts) {
+    std::string file = tmp + "/" + artifact.name;
+    if (!artifact.shared.empty()) {
+      fs::create_hard_link(artifact.shared, file, ec);
+      if (!ec)
+        continue;
+    }
+    if (!fs::copy_file(artifact.path, file, ec))
+      break;
+  }
+  if (!ec && !warnings.empty()) {
+    std::ofstream out(tmp + "/" + WARNINGS);
+    out << warnings;
+  }
+  // Another compile may have stored the same entry first; either copy will
+  // do.
+  if (!ec)
+    fs::rename(tmp, entry, ec);
+  if (ec)
+    fs::remove_all(tmp, ec);
+  evictLeastRecentlyUsed(cacheDir, MAX_ENTRIES);
+}
+
+uint64_t buildKey(uint64_t sourceHash, const std::string &compilerPath,
+                  const std::string &options) {
+  uint64_t key = fnv1a(engineSource(compilerPath), compilerHash());
+  key = fnv1a(options, key);
+  return fnv1a(std::string_view(reinterpret_cast<const char *>(&sourceHash),
+                                sizeof(sourceHash)),
+               key);
+}
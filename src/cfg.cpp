@@ -0,0 +1,97 @@
+#include <cfg.hpp>
+#include <unordered_map>
+
+namespace {
+
+// Index of each label by name. A repeated label resolves to its last
+// definition, as in the engine's label map.
+std::unordered_map<Symbol, uint32_t> labelIndex(const FlatProgram &program) {
+  std::unordered_map<Symbol, uint32_t> index;
+  index.reserve(program.labels.size());
+  for (uint32_t i = 0; i < program.labels.size(); ++i)
+    index[program.labels[i].name] = i;
+  return index;
+}
+
+} // namespace
+
+Range liveStmts(const FlatProgram &program, const FlatLabel &label) {
+  for (uint32_t s = label.stmts.first; s < label.stmts.end(); ++s) {
+    StmtKind kind = program.stmts[s].kind;
+    if (kind == StmtKind::JUMP || kind == StmtKind::CHOICE ||
+        kind == StmtKind::END)
+      return {label.stmts.first, s + 1 - label.stmts.first};
+  }
+  return label.stmts;
+}
+
+StoryGraph buildStoryGraph(const FlatProgram &program) {
+  std::unordered_map<Symbol, uint32_t> index = labelIndex(program);
+  StoryGraph graph;
+  graph.successors.reserve(program.labels.size());
+
+  auto edge = [&](Symbol target) {
+    auto it = index.find(target);
+    if (it != index.end())
+      graph.edges.push_back(it->second);
+  };
+
+  for (uint32_t i = 0; i < program.labels.size(); ++i) {
+    Range out{static_cast<uint32_t>(graph.edges.size()), 0};
+    Range live = liveStmts(program, program.labels[i]);
+    const Stmt *last = live.count ? &program.stmts[live.end() - 1] : nullptr;
+    // An empty label falls through like one without a jump.
+    StmtKind kind = last ? last->kind : StmtKind::SCENE;
+    if (kind == StmtKind::JUMP) {
+      edge(program.jumps[last->index].target);
+    } else if (kind == StmtKind::CHOICE) {
+      const Range &options = program.choices[last->index].options;
+      for (uint32_t o = options.first; o < options.end(); ++o)
+        edge(program.options[o].target);
+    } else if (kind != StmtKind::END && i + 1 < program.labels.size()) {
+      graph.edges.push_back(i + 1);
+    }
+    out.count = static_cast<uint32_t>(graph.edges.size()) - out.first;
+    graph.successors.push_back(out);
+  }
+  return graph;
+}
+
+std::vector<bool> reachableLabels(const StoryGraph &graph, uint32_t entry) {
+  std::vector<bool> reached(graph.successors.size());
+  std::vector<uint32_t> pending{entry};
+  reached[entry] = true;
+  while (!pending.empty()) {
+    uint32_t label = pending.back();
+    pending.pop_back();
+    const Range &out = graph.successors[label];
+    for (uint32_t e = out.first; e < out.end(); ++e) {
+      uint32_t next = graph.edges[e];
+      if (!reached[next]) {
+        reached[next] = true;
+        pending.push_back(next);
+      }
+    }
+  }
+  return reached;
+}
+
+std::vector<Symbol> removeUnreachableLabels(FlatProgram &program) {
+  std::vector<Symbol> removed;
+  std::unordered_map<Symbol, uint32_t> index = labelIndex(program);
+  auto start = index.find(intern("start"));
+  if (start == index.end())
+    return removed;
+
+  std::vector<bool> reached =
+      reachableLabels(buildStoryGraph(program), start->second);
+  size_t kept = 0;
+  for (size_t i = 0; i < program.labels.size(); ++i) {
+    if (reached[i])
+      program.labels[kept++] = program.labels[i];
+    else
+      removed.push_back(program.labels[i].name);
+  }
+  program.labels.resize(kept);
+  return removed;
+}
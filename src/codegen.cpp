@@ -0,0 +1,1467 @@
+#include <cfg.hpp>
+#include <codegen.hpp>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <output_buffer.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <story_format.hpp>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view ENGINE_INCLUDES = R"__(#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+)__";
+
+void generateEngineCode(std::ostream &out, const std::string &compilerPath) {
+  std::string story_path_str = compilerPath + "/.tmp/story.bin";
+
+  out << ENGINE_INCLUDES << R"__(
+constexpr int WINDOW_WIDTH = 1600;
+constexpr int WINDOW_HEIGHT = 800;
+constexpr int TEXT_BOX_POSX = 0;
+constexpr int TEXT_BOX_POSY = WINDOW_HEIGHT * 0.65;
+constexpr int TEXT_BOX_WIDTH = WINDOW_WIDTH;
+constexpr int TEXT_BOX_HEIGHT = WINDOW_HEIGHT - TEXT_BOX_POSY;
+constexpr int TEXT_BOX_PADDING = 100;
+constexpr int DIALOGUE_SIZE = 36;
+constexpr int DIALOGUE_POSX = TEXT_BOX_POSX + 20;
+constexpr int DIALOGUE_POSY = TEXT_BOX_POSY + 20;
+constexpr int CHOICE_BOX_WIDTH = 1400;
+constexpr int CHOICE_BOX_PADDING = 50;
+constexpr int TEXT_OPTION_SIZE = 24;
+constexpr int OPTION_PADDING = 10;
+constexpr int OPTION_MARGIN = 10;
+constexpr int PROMPT_SIZE = 24;
+constexpr int PROMPT_MARGIN = 10;
+
+std::string wrapText(const std::string &text, unsigned int lineLength,
+                     const sf::Font &font, unsigned int charSize) {
+  std::string wrappedText;
+  std::string currentLine;
+  std::string word;
+  sf::Text tempText(font, "", charSize);
+
+  for (char c : text) {
+    if (c == ' ' || c == '\n') {
+      tempText.setString(currentLine + word);
+
+      if (tempText.getGlobalBounds().size.x > lineLength) {
+        wrappedText += currentLine + '\n';
+        currentLine.clear();
+
+        currentLine += word + c;
+      } else {
+        currentLine += word + ' ';
+      }
+
+      word.clear();
+    } else {
+      word += c;
+    }
+  }
+  tempText.setString(currentLine + word);
+  if (tempText.getLocalBounds().size.x > lineLength) {
+    wrappedText += currentLine + '\n' + word;
+  } else {
+    wrappedText += currentLine + word;
+  }
+  return wrappedText;
+}
+
+class TextureManager {
+private:
+  std::map<std::string, std::shared_ptr<sf::Texture>> textures;
+  TextureManager() = default;
+
+public:
+  static TextureManager &getInstance() {
+    static TextureManager instance;
+    return instance;
+  }
+  std::shared_ptr<sf::Texture> loadTexture(const std::string &path) {
+    if (textures.count(path)) {
+      return textures[path];
+    }
+    auto texture = std::make_shared<sf::Texture>();
+    if (!texture->loadFromFile(path)) {
+      std::cerr << "Error cargando textura: " << path << std::endl;
+      return nullptr;
+    }
+    textures[path] = texture;
+    return texture;
+  }
+};
+
+// Mirrors include/story_format.hpp in the compiler.
+using StringId = uint32_t;
+constexpr StringId NO_STRING = UINT32_MAX;
+constexpr uint32_t STORY_VERSION = )__"
+      << STORY_VERSION << R"__(;
+constexpr uint32_t STORY_NO_ENTRY = UINT32_MAX;
+
+struct StoryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t strings;
+  uint32_t backgrounds;
+  uint32_t music;
+  uint32_t characters;
+  uint32_t modes;
+  uint32_t commands;
+  uint32_t options;
+  uint32_t textBytes;
+  uint32_t entry;
+};
+
+struct StoryString {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct StoryAsset {
+  StringId name;
+  StringId path;
+};
+
+struct StoryCharacter {
+  StringId name;
+  StringId displayName;
+  uint32_t firstMode;
+  uint32_t modeCount;
+};
+
+struct StoryMode {
+  StringId name;
+  StringId path;
+  float scaleX;
+  float scaleY;
+};
+
+enum class StoryOp : uint32_t {
+  SCENE,
+  SHOW,
+  HIDE,
+  DIALOGUE,
+  PLAY,
+  STOP,
+  CHOICE,
+  JUMP,
+  END
+};
+
+struct StoryCommand {
+  StoryOp op;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  float x;
+  float y;
+};
+
+struct StoryOption {
+  StringId text;
+  uint32_t target;
+};
+
+#ifdef STORY_EMBEDDED
+// The story image linked into the game; see generateStorySource().
+extern const char STORY_DATA[];
+extern const size_t STORY_SIZE;
+#endif
+
+// story.bin mapped read-only, or the image built into the game. Commands and
+// strings are used in place.
+class Story {
+  void *data_ = MAP_FAILED;
+  size_t size_ = 0;
+  const StoryHeader *header_ = nullptr;
+  const StoryString *strings_ = nullptr;
+  const StoryAsset *backgrounds_ = nullptr;
+  const StoryAsset *music_ = nullptr;
+  const StoryCharacter *characters_ = nullptr;
+  const StoryMode *modes_ = nullptr;
+  const StoryCommand *commands_ = nullptr;
+  const StoryOption *options_ = nullptr;
+  const char *text_ = nullptr;
+
+  template <typename T> static const T *take(const char *&p, uint32_t count) {
+    const T *array = reinterpret_cast<const T *>(p);
+    p += sizeof(T) * count;
+    return array;
+  }
+
+  bool validate(size_t size) const {
+    const StoryHeader &h = *header_;
+    if (std::memcmp(h.magic, "SSTB", 4) != 0 || h.version != STORY_VERSION)
+      return false;
+    size_t expected = sizeof(StoryHeader) + sizeof(StoryString) * h.strings +
+                      sizeof(StoryAsset) * (size_t(h.backgrounds) + h.music) +
+                      sizeof(StoryCharacter) * h.characters +
+                      sizeof(StoryMode) * h.modes +
+                      sizeof(StoryCommand) * h.commands +
+                      sizeof(StoryOption) * h.options + h.textBytes;
+    return expected == size;
+  }
+
+public:
+  Story() = default;
+  Story(const Story &) = delete;
+  Story &operator=(const Story &) = delete;
+  ~Story() { close(); }
+
+  void close() {
+    if (data_ != MAP_FAILED)
+      munmap(data_, size_);
+    data_ = MAP_FAILED;
+    size_ = 0;
+  }
+
+  bool open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(StoryHeader)) {
+      ::close(fd);
+      return false;
+    }
+    size_ = st.st_size;
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data_ == MAP_FAILED)
+      return false;
+    return attach(static_cast<const char *>(data_), size_);
+  }
+
+  // Reads the story in place from size bytes at data, which must be 4-byte
+  // aligned and outlive the story.
+  bool attach(const char *data, size_t size) {
+    if (size < sizeof(StoryHeader))
+      return false;
+    const char *p = data;
+    header_ = take<StoryHeader>(p, 1);
+    if (!validate(size))
+      return false;
+    strings_ = take<StoryString>(p, header_->strings);
+    backgrounds_ = take<StoryAsset>(p, header_->backgrounds);
+    music_ = take<StoryAsset>(p, header_->music);
+    characters_ = take<StoryCharacter>(p, header_->characters);
+    modes_ = take<StoryMode>(p, header_->modes);
+    commands_ = take<StoryCommand>(p, header_->commands);
+    options_ = take<StoryOption>(p, header_->options);
+    text_ = p;
+    return true;
+  }
+
+  const StoryHeader &header() const { return *header_; }
+  std::string_view str(StringId id) const {
+    return {text_ + strings_[id].offset, strings_[id].size};
+  }
+  const StoryAsset *backgrounds() const { return backgrounds_; }
+  const StoryAsset *music() const { return music_; }
+  const StoryCharacter *characters() const { return characters_; }
+  const StoryMode *modes() const { return modes_; }
+  const StoryCommand &command(size_t index) const { return commands_[index]; }
+  const StoryOption *options() const { return options_; }
+};
+
+struct Transform {
+  sf::Vector2f position = {0.0f, 0.0f};
+  sf::Vector2f scale = {1.0f, 1.0f};
+};
+
+class SceneComponent {
+public:
+  virtual ~SceneComponent() = default;
+  virtual void draw(sf::RenderWindow &window) = 0;
+  virtual void setVisibility(bool) {};
+  virtual void setPosition(const sf::Vector2f &) {};
+  virtual void setScale(const sf::Vector2f &) {};
+  virtual void setFocused(bool) {};
+  virtual void update(float) {};
+};
+
+class SpriteComponent : public SceneComponent {
+  std::shared_ptr<sf::Texture> texture_;
+  std::unique_ptr<sf::Sprite> sprite_;
+  Transform transform_;
+  bool isVisible_ = true;
+
+public:
+  SpriteComponent(std::shared_ptr<sf::Texture> texture,
+                  const Transform &transform)
+      : texture_(texture), transform_(transform) {
+    if (texture_) {
+      sprite_ = std::make_unique<sf::Sprite>(*texture_);
+      sprite_->setPosition(transform_.position);
+      sprite_->setScale(transform_.scale);
+    } else {
+      std::cerr << "Error: SpriteComponent creado con textura nula.\n";
+    }
+  }
+  void draw(sf::RenderWindow &window) override {
+    if (isVisible_ && sprite_)
+      window.draw(*sprite_);
+  }
+  void setVisibility(bool visible) override { isVisible_ = visible; }
+  void setPosition(const sf::Vector2f &pos) override {
+    transform_.position = pos;
+    if (sprite_)
+      sprite_->setPosition(pos);
+  }
+  void setScale(const sf::Vector2f &scale) override {
+    transform_.scale = scale;
+    if (sprite_)
+      sprite_->setScale(scale);
+  }
+  void setFocused(bool isFocused) override {
+    if (sprite_)
+      sprite_->setColor(isFocused ? sf::Color::White
+                                  : sf::Color(128, 128, 128));
+  }
+};
+
+class CharacterState {
+public:
+  virtual ~CharacterState() = default;
+  virtual std::shared_ptr<SpriteComponent> getSprite() = 0;
+};
+
+class GenericCharacterState : public CharacterState {
+  std::shared_ptr<SpriteComponent> sprite_;
+
+public:
+  GenericCharacterState(const std::string &texturePath,
+                        const Transform &transform) {
+    auto texture = TextureManager::getInstance().loadTexture(texturePath);
+    sprite_ = std::make_shared<SpriteComponent>(texture, transform);
+  }
+  std::shared_ptr<SpriteComponent> getSprite() override { return sprite_; }
+};
+
+class Character : public SceneComponent {
+  std::string id_, name_;
+  StringId currentState_ = NO_STRING;
+  std::unordered_map<StringId, std::unique_ptr<CharacterState>> states_;
+  bool isVisible_ = false;
+
+public:
+  Character(const std::string &id, const std::string &name)
+      : id_(id), name_(name) {}
+  void addState(StringId stateName, const std::string &texturePath,
+                const Transform &transform) {
+    states_[stateName] =
+        std::make_unique<GenericCharacterState>(texturePath, transform);
+  }
+  void setState(StringId stateName) {
+    if (states_.count(stateName)) {
+      currentState_ = stateName;
+    }
+  }
+  void draw(sf::RenderWindow &window) override {
+    if (isVisible_ && states_.count(currentState_)) {
+      states_[currentState_]->getSprite()->draw(window);
+    }
+  }
+  void setVisibility(bool visible) override { isVisible_ = visible; }
+  void setPosition(const sf::Vector2f &pos) override {
+    if (states_.count(currentState_))
+      states_[currentState_]->getSprite()->setPosition(pos);
+  }
+  void setScale(const sf::Vector2f &scale) override {
+    if (states_.count(currentState_))
+      states_[currentState_]->getSprite()->setScale(scale);
+  }
+  void setFocused(bool isFocused) override {
+    if (states_.count(currentState_))
+      states_[currentState_]->getSprite()->setFocused(isFocused);
+  }
+  const std::string &getName() const { return name_; }
+};
+
+class Background : public SceneComponent {
+  std::shared_ptr<sf::Texture> texture_;
+  std::unique_ptr<sf::Sprite> sprite_;
+  bool isVisible_ = false;
+
+public:
+  Background(const std::string &texturePath) {
+    texture_ = TextureManager::getInstance().loadTexture(texturePath);
+    if (texture_) {
+      sprite_ = std::make_unique<sf::Sprite>(*texture_);
+      sf::Vector2u texSize = texture_->getSize();
+      float scaleX = static_cast<float>(WINDOW_WIDTH) / texSize.x;
+      float scaleY = static_cast<float>(WINDOW_HEIGHT) / texSize.y;
+      sprite_->setScale({scaleX, scaleY});
+    }
+  }
+  void draw(sf::RenderWindow &window) override {
+    if (isVisible_ && sprite_) {
+      window.draw(*sprite_);
+    }
+  }
+  void setVisibility(bool visible) override { isVisible_ = visible; }
+};
+
+class DialogueSystem : public SceneComponent {
+  sf::RectangleShape textBox_;
+  sf::Text dialogueText_;
+  bool isVisible_ = false;
+  std::string fullText_;
+  std::string currentTypedText_;
+  size_t charIndex_ = 0;
+  float timePerChar_ = 0.05f;
+  float elapsedTime_ = 0.0f;
+  bool isTyping_ = false;
+
+public:
+  DialogueSystem(const sf::Font &font) : dialogueText_(font, "") {
+    textBox_.setSize({(float)TEXT_BOX_WIDTH, (float)TEXT_BOX_HEIGHT});
+    textBox_.setPosition({(float)TEXT_BOX_POSX, (float)TEXT_BOX_POSY});
+    textBox_.setFillColor(sf::Color(0, 0, 0, 200));
+    dialogueText_.setCharacterSize(DIALOGUE_SIZE);
+    dialogueText_.setFillColor(sf::Color::White);
+    dialogueText_.setPosition({(float)DIALOGUE_POSX, (float)DIALOGUE_POSY});
+  }
+
+  void start(const std::string &text, float speed) {
+    fullText_ =
+        wrapText(text, TEXT_BOX_WIDTH - TEXT_BOX_PADDING,
+                 dialogueText_.getFont(), dialogueText_.getCharacterSize());
+    currentTypedText_.clear();
+    charIndex_ = 0;
+    elapsedTime_ = 0.0f;
+    timePerChar_ = (speed > 0) ? 1.0f / speed : 0.0f;
+    isTyping_ = true;
+    isVisible_ = true;
+    dialogueText_.setString("");
+  }
+
+  void update(float deltaTime) override {
+    if (!isTyping_ || charIndex_ >= fullText_.length())
+      return;
+    elapsedTime_ += deltaTime;
+    if (elapsedTime_ >= timePerChar_) {
+      elapsedTime_ = 0.0f;
+      currentTypedText_ += fullText_[charIndex_];
+      dialogueText_.setString(currentTypedText_);
+      charIndex_++;
+      if (charIndex_ >= fullText_.length()) {
+        isTyping_ = false;
+      }
+    }
+  }
+
+  void finish() {
+    if (isTyping_) {
+      isTyping_ = false;
+      charIndex_ = fullText_.length();
+      currentTypedText_ = fullText_;
+      dialogueText_.setString(fullText_);
+    }
+  }
+
+  bool isFinished() const { return !isTyping_; }
+  bool isVisible() const { return isVisible_; }
+  void hide() { isVisible_ = false; }
+  void draw(sf::RenderWindow &window) override {
+    if (isVisible_) {
+      window.draw(textBox_);
+      window.draw(dialogueText_);
+    }
+  }
+};
+
+class SceneManager {
+  std::vector<std::shared_ptr<SceneComponent>> components_;
+
+public:
+  void addComponent(const std::string &id,
+                    std::shared_ptr<SceneComponent> component) {
+    components_.push_back(component);
+  }
+  void clear() { components_.clear(); }
+  void draw(sf::RenderWindow &window) {
+    for (auto &comp : components_) {
+      comp->draw(window);
+    }
+  }
+  void update(float deltaTime) {
+    for (auto &comp : components_) {
+      comp->update(deltaTime);
+    }
+  }
+};
+
+class ChoiceBox : public SceneComponent {
+private:
+  sf::RectangleShape background_;
+  sf::Text promptText_;
+  std::vector<sf::Text> optionTexts_;
+  std::vector<sf::RectangleShape> optionRects_;
+  sf::Font font_;
+  bool isVisible_ = false;
+  int hoveredOption_ = -1;
+  std::vector<size_t> targets_;
+
+public:
+  ChoiceBox(const sf::Font &font) : promptText_(font, ""), font_(font) {
+    background_.setSize({CHOICE_BOX_WIDTH, 100});
+    background_.setFillColor(sf::Color(0, 0, 0, 180));
+    promptText_.setFont(font_);
+    promptText_.setCharacterSize(TEXT_OPTION_SIZE);
+    promptText_.setFillColor(sf::Color::White);
+  }
+
+  void setOptions(const std::string &prompt, const StoryOption *options,
+                  size_t count, const Story &story) {
+    optionTexts_.clear();
+    optionRects_.clear();
+    targets_.clear();
+
+    promptText_.setString(
+        wrapText(prompt, CHOICE_BOX_WIDTH * 0.9, font_, PROMPT_SIZE));
+
+    float totalHeight =
+        PROMPT_MARGIN * 2 + promptText_.getGlobalBounds().size.y;
+    float optionWidth = background_.getSize().x * 0.9;
+
+    for (size_t i = 0; i < count; ++i) {
+      const StoryOption &option = options[i];
+      sf::Text optionText(font_, "", TEXT_OPTION_SIZE);
+      optionText.setFillColor(sf::Color::White);
+      std::string wrapped = wrapText(std::string(story.str(option.text)),
+                                     optionWidth * 0.9, font_,
+                                     TEXT_OPTION_SIZE);
+      optionText.setString(wrapped);
+
+      totalHeight += optionText.getGlobalBounds().size.y + OPTION_PADDING * 2 +
+                     OPTION_MARGIN * 2;
+
+      sf::RectangleShape optionRect;
+      optionRect.setFillColor(sf::Color(50, 50, 50, 180));
+      optionRect.setOutlineThickness(2);
+      optionRect.setOutlineColor(sf::Color(100, 100, 100, 200));
+
+      optionTexts_.push_back(optionText);
+      optionRects_.push_back(optionRect);
+      targets_.push_back(option.target);
+    }
+
+    background_.setSize(
+        {CHOICE_BOX_WIDTH, totalHeight + CHOICE_BOX_PADDING * 2});
+    background_.setPosition({(WINDOW_WIDTH - background_.getSize().x) / 2.0f,
+                             (WINDOW_HEIGHT - background_.getSize().y) / 2.0f});
+
+    promptText_.setPosition(
+        {((background_.getSize().x - promptText_.getGlobalBounds().size.x) /
+          2.0f) +
+             background_.getPosition().x,
+         background_.getPosition().y + CHOICE_BOX_PADDING + PROMPT_MARGIN});
+
+    float currentY = promptText_.getPosition().y +
+                     promptText_.getGlobalBounds().size.y + PROMPT_MARGIN;
+
+    for (size_t i = 0; i < optionTexts_.size(); ++i) {
+      float optionHeight =
+          optionTexts_[i].getGlobalBounds().size.y + OPTION_PADDING * 2;
+
+      optionRects_[i].setSize({optionWidth, optionHeight});
+      optionRects_[i].setPosition(
+          {((background_.getSize().x - optionWidth) / 2.0f) +
+               background_.getPosition().x,
+           currentY + OPTION_MARGIN});
+      optionTexts_[i].setPosition(
+          {optionRects_[i].getPosition().x +
+               (optionWidth - optionTexts_[i].getGlobalBounds().size.x) / 2.0f,
+           currentY + (optionHeight + OPTION_MARGIN -
+                       optionTexts_[i].getGlobalBounds().size.y) /
+                          2.0f});
+      currentY += optionHeight + OPTION_MARGIN * 2;
+    }
+    isVisible_ = true;
+  }
+
+  void draw(sf::RenderWindow &window) override {
+    if (!isVisible_)
+      return;
+
+    window.draw(background_);
+    window.draw(promptText_);
+    for (size_t i = 0; i < optionRects_.size(); ++i) {
+      window.draw(optionRects_[i]);
+    }
+    for (const auto &text : optionTexts_) {
+      window.draw(text);
+    }
+  }
+
+  void setVisibility(bool visible) override { isVisible_ = visible; }
+  bool isVisible() const { return isVisible_; }
+
+  int handleMouseClick(sf::Vector2i mousePos) {
+    if (!isVisible_)
+      return -1;
+
+    for (size_t i = 0; i < optionRects_.size(); ++i) {
+      if (optionRects_[i].getGlobalBounds().contains(
+              static_cast<sf::Vector2f>(mousePos))) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  void handleMouseMove(sf::Vector2i mousePos) {
+    if (!isVisible_)
+      return;
+
+    int oldHovered = hoveredOption_;
+    hoveredOption_ = -1;
+    for (size_t i = 0; i < optionRects_.size(); ++i) {
+      if (optionRects_[i].getGlobalBounds().contains(
+              static_cast<sf::Vector2f>(mousePos))) {
+        hoveredOption_ = i;
+        break;
+      }
+    }
+
+    if (hoveredOption_ != oldHovered) {
+      for (size_t i = 0; i < optionRects_.size(); ++i) {
+        if (i == hoveredOption_) {
+          optionRects_[i].setFillColor(sf::Color(80, 80, 80, 200));
+        } else {
+          optionRects_[i].setFillColor(sf::Color(50, 50, 50, 180));
+        }
+      }
+    }
+  }
+
+  size_t getTarget(int index) const { return targets_[index]; }
+};
+
+class VisualNovelEngine {
+public:
+  enum class State {
+    IDLE,
+    EXECUTING_COMMAND,
+    WRITING_DIALOGUE,
+    WAITING_FOR_INPUT,
+    WAITING_FOR_CHOICE
+  };
+
+  void initialize(const std::string &storyPath) {
+    window_.create(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}), "visualNovel",
+                   sf::Style::Close | sf::Style::Titlebar);
+    window_.setPosition({100, 100});
+    window_.setFramerateLimit(60);
+    if (!font_.openFromFile(
+            "assets/fonts/WinkyRough-Italic-VariableFont_wght.ttf")) {
+      std::cerr << "Error: No se pudo cargar la fuente.\n";
+      return;
+    }
+
+    dialogueSystem_ = std::make_shared<DialogueSystem>(font_);
+    choiceBox_ = std::make_shared<ChoiceBox>(font_);
+
+    storyPath_ = storyPath;
+    if (!loadStoryFromFile(storyPath)) {
+      std::cerr << "Error: No se pudo cargar la historia desde " << storyPath
+                << std::endl;
+      return;
+    }
+    begin();
+  }
+
+  void run() {
+    sf::Clock clock;
+    while (window_.isOpen()) {
+      sf::Time elapsed = clock.restart();
+#ifndef STORY_EMBEDDED
+      if (storyChanged(elapsed.asSeconds()))
+        reloadStory();
+#endif
+      handleEvents();
+      update(elapsed.asSeconds());
+      render();
+    }
+  }
+
+private:
+  State currentState_ = State::IDLE;
+  bool waitForMouseReleaseForChoice_ = false;
+  sf::RenderWindow window_;
+  sf::Font font_;
+  SceneManager sceneManager_;
+
+  Story story_;
+  std::string storyPath_;
+#ifndef STORY_EMBEDDED
+  // story.bin as it was when loaded; `compiler --watch` replaces the file.
+  ino_t storyInode_ = 0;
+  time_t storyTime_ = 0;
+  float sinceStoryCheck_ = 0.0f;
+#endif
+  // Assets by the string id of their name.
+  std::unordered_map<StringId, std::shared_ptr<Character>> characters_;
+  std::unordered_map<StringId, std::shared_ptr<Background>> backgrounds_;
+  std::unordered_map<StringId, std::shared_ptr<sf::Music>> musicTracks_;
+
+  std::shared_ptr<DialogueSystem> dialogueSystem_;
+  std::shared_ptr<ChoiceBox> choiceBox_;
+  size_t commandIndex_ = 0;
+  StringId currentBackground_ = NO_STRING;
+  StringId currentMusicId_ = NO_STRING;
+
+  bool loadStoryFromFile(const std::string &path) {
+#ifdef STORY_EMBEDDED
+    (void)path;
+    if (!story_.attach(STORY_DATA, STORY_SIZE)) {
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+      storyInode_ = st.st_ino;
+      storyTime_ = st.st_mtime;
+    }
+    if (!story_.open(path)) {
+#endif
+      return false;
+    }
+    const StoryHeader &header = story_.header();
+
+    for (uint32_t i = 0; i < header.backgrounds; ++i) {
+      const StoryAsset &asset = story_.backgrounds()[i];
+      auto bg =
+          std::make_shared<Background>(std::string(story_.str(asset.path)));
+      backgrounds_[asset.name] = bg;
+      sceneManager_.addComponent("bg_" + std::string(story_.str(asset.name)),
+                                 bg);
+    }
+    for (uint32_t i = 0; i < header.music; ++i) {
+      const StoryAsset &asset = story_.music()[i];
+      std::string path(story_.str(asset.path));
+      auto music = std::make_shared<sf::Music>();
+      if (music->openFromFile(path)) {
+        musicTracks_[asset.name] = music;
+      } else {
+        std::cerr << "Error al cargar música: " << path << "\n";
+      }
+    }
+    for (uint32_t i = 0; i < header.characters; ++i) {
+      const StoryCharacter &entry = story_.characters()[i];
+      std::string key(story_.str(entry.name));
+      auto character = std::make_shared<Character>(
+          key, std::string(story_.str(entry.displayName)));
+      for (uint32_t m = 0; m < entry.modeCount; ++m) {
+        const StoryMode &mode = story_.modes()[entry.firstMode + m];
+        Transform transform;
+        transform.scale = {mode.scaleX, mode.scaleY};
+        character->addState(mode.name, std::string(story_.str(mode.path)),
+                            transform);
+      }
+      characters_[entry.name] = character;
+      sceneManager_.addComponent("char_" + key, character);
+    }
+    return true;
+  }
+
+  // Runs the story from its `start` label.
+  void begin() {
+    currentState_ = State::IDLE;
+    if (story_.header().commands == 0)
+      return;
+    if (story_.header().entry == STORY_NO_ENTRY) {
+      std::cerr << "Error: 'start' label not found in story.bin\n";
+      return;
+    }
+    commandIndex_ = story_.header().entry;
+    currentState_ = State::EXECUTING_COMMAND;
+  }
+
+#ifndef STORY_EMBEDDED
+  // Whether story.bin was replaced since it was loaded. Checked a few times
+  // a second.
+  bool storyChanged(float deltaTime) {
+    sinceStoryCheck_ += deltaTime;
+    if (sinceStoryCheck_ < 0.25f)
+      return false;
+    sinceStoryCheck_ = 0.0f;
+    struct stat st;
+    if (stat(storyPath_.c_str(), &st) != 0)
+      return false;
+    return st.st_ino != storyInode_ || st.st_mtime != storyTime_;
+  }
+
+  // Drops the assets of the old story and starts the new one from the top.
+  void reloadStory() {
+    for (auto const &[id, music] : musicTracks_) {
+      music->stop();
+    }
+    characters_.clear();
+    backgrounds_.clear();
+    musicTracks_.clear();
+    sceneManager_.clear();
+    dialogueSystem_->hide();
+    choiceBox_->setVisibility(false);
+    currentBackground_ = NO_STRING;
+    currentMusicId_ = NO_STRING;
+    currentState_ = State::IDLE;
+    if (!loadStoryFromFile(storyPath_)) {
+      std::cerr << "Error: No se pudo cargar la historia desde " << storyPath_
+                << std::endl;
+      return;
+    }
+    std::cerr << "Historia recargada.\n";
+    begin();
+  }
+#endif
+
+  void update(float deltaTime) {
+    if (currentState_ == State::EXECUTING_COMMAND) {
+      executeNextCommand();
+    }
+    sceneManager_.update(deltaTime);
+    dialogueSystem_->update(deltaTime);
+  }
+
+  void executeNextCommand() {
+    if (commandIndex_ >= story_.header().commands) {
+      dialogueSystem_->hide();
+      currentState_ = State::IDLE;
+      std::cerr << "DEBUG: Reached end of script. commandIndex_ = "
+                << commandIndex_
+                << ", commands = " << story_.header().commands << std::endl;
+      return;
+    }
+
+    const StoryCommand &cmd = story_.command(commandIndex_);
+    if (cmd.op == StoryOp::DIALOGUE) {
+      std::string_view speakerId = story_.str(cmd.a);
+      bool narrator = speakerId == "You";
+      std::string speakerName = narrator ? "" : std::string(speakerId);
+      if (auto it = characters_.find(cmd.a); it != characters_.end()) {
+        speakerName = it->second->getName();
+      }
+      for (auto const &[id, character] : characters_) {
+        character->setFocused(id == cmd.a || narrator);
+      }
+      std::string text(story_.str(cmd.b));
+      dialogueSystem_->start(
+          speakerName.empty() ? text : speakerName + ":\n" + text, cmd.x);
+      currentState_ = State::WRITING_DIALOGUE;
+      return;
+    }
+    if (cmd.op == StoryOp::CHOICE) {
+      dialogueSystem_->hide();
+      choiceBox_->setOptions(std::string(story_.str(cmd.a)),
+                             story_.options() + cmd.b, cmd.c, story_);
+      currentState_ = State::WAITING_FOR_CHOICE;
+      if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
+        waitForMouseReleaseForChoice_ = true;
+      } else {
+        waitForMouseReleaseForChoice_ = false;
+      }
+      return;
+    }
+
+    for (auto const &[id, character] : characters_) {
+      character->setFocused(true);
+    }
+    switch (cmd.op) {
+    case StoryOp::SCENE:
+      if (auto it = backgrounds_.find(currentBackground_);
+          it != backgrounds_.end())
+        it->second->setVisibility(false);
+      if (auto it = backgrounds_.find(cmd.a); it != backgrounds_.end())
+        it->second->setVisibility(true);
+      currentBackground_ = cmd.a;
+      break;
+    case StoryOp::SHOW:
+      if (auto it = characters_.find(cmd.a); it != characters_.end()) {
+        it->second->setState(cmd.b);
+        it->second->setPosition({cmd.x, cmd.y});
+        it->second->setVisibility(true);
+      }
+      break;
+    case StoryOp::HIDE:
+      if (auto it = characters_.find(cmd.a); it != characters_.end()) {
+        it->second->setVisibility(false);
+      }
+      break;
+    case StoryOp::PLAY:
+      if (auto it = musicTracks_.find(currentMusicId_);
+          it != musicTracks_.end()) {
+        it->second->stop();
+      }
+      if (auto it = musicTracks_.find(cmd.a); it != musicTracks_.end()) {
+        currentMusicId_ = cmd.a;
+        it->second->setLooping(true);
+        it->second->play();
+      }
+      break;
+    case StoryOp::STOP:
+      if (auto it = musicTracks_.find(cmd.a); it != musicTracks_.end()) {
+        it->second->stop();
+        if (currentMusicId_ == cmd.a) {
+          currentMusicId_ = NO_STRING;
+        }
+      }
+      break;
+    case StoryOp::END:
+      window_.close();
+      currentState_ = State::IDLE;
+      break;
+    case StoryOp::JUMP:
+      commandIndex_ = cmd.a;
+      currentState_ = State::EXECUTING_COMMAND;
+      return;
+    default:
+      break;
+    }
+    currentState_ = State::EXECUTING_COMMAND;
+    commandIndex_++;
+  }
+
+  void handleEvents() {
+    while (std::optional<sf::Event> event = window_.pollEvent()) {
+      if (event->is<sf::Event::Closed>()) {
+        window_.close();
+      }
+      if (auto *keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+        if (keyPressed->code == sf::Keyboard::Key::Space) {
+          if (dialogueSystem_->isFinished() && currentState_ == State::WRITING_DIALOGUE) {
+            currentState_ = State::EXECUTING_COMMAND;
+            commandIndex_++;
+          }
+
+          if (currentState_ == State::WRITING_DIALOGUE) {
+            dialogueSystem_->finish();
+            currentState_ = State::WAITING_FOR_INPUT;
+          } else if (currentState_ == State::WAITING_FOR_INPUT) {
+            currentState_ = State::EXECUTING_COMMAND;
+            commandIndex_++;
+          }
+        }
+      }
+      if (currentState_ == State::WAITING_FOR_CHOICE) {
+        if (auto *mouseButtonReleased =
+                event->getIf<sf::Event::MouseButtonReleased>()) {
+          if (mouseButtonReleased->button == sf::Mouse::Button::Left) {
+            if (waitForMouseReleaseForChoice_) {
+              waitForMouseReleaseForChoice_ = false;
+              return;
+            }
+            int chosenOptionIndex =
+                choiceBox_->handleMouseClick(sf::Mouse::getPosition(window_));
+            if (chosenOptionIndex != -1) {
+              if (story_.command(commandIndex_).op == StoryOp::CHOICE) {
+                commandIndex_ = choiceBox_->getTarget(chosenOptionIndex);
+                currentState_ = State::EXECUTING_COMMAND;
+                choiceBox_->setVisibility(false);
+              }
+            }
+          }
+        } else if (auto *mouseMoved = event->getIf<sf::Event::MouseMoved>()) {
+          choiceBox_->handleMouseMove(
+              {mouseMoved->position.x, mouseMoved->position.y});
+        }
+      }
+    }
+  }
+
+  void render() {
+    window_.clear(sf::Color::Black);
+    sceneManager_.draw(window_);
+    dialogueSystem_->draw(window_);
+    choiceBox_->draw(window_);
+    window_.display();
+  }
+};
+
+int main(int argc, char *argv[]) {
+  // Ignored when the story is built into the game.
+  std::string storyFile = ")__" +
+             story_path_str + R"__(";
+  if (argc > 1) {
+    storyFile = argv[1];
+  }
+
+  VisualNovelEngine engine;
+  engine.initialize(storyFile);
+  engine.run();
+  return 0;
+}
+)__";
+}
+
+std::string absolutePath(std::string_view path) {
+  return std::filesystem::absolute(path).string();
+}
+
+// Dialogue and choice text, each distinct string stored once. Commands refer
+// to it by index.
+class StringTable {
+  std::unordered_map<std::string_view, uint32_t> ids;
+  std::vector<std::string_view> strings;
+
+public:
+  uint32_t add(std::string_view s) {
+    auto [it, inserted] =
+        ids.try_emplace(s, static_cast<uint32_t>(strings.size()));
+    if (inserted)
+      strings.push_back(s);
+    return it->second;
+  }
+
+  void reserve(size_t n) {
+    ids.reserve(n);
+    strings.reserve(n);
+  }
+
+  const std::vector<std::string_view> &all() const { return strings; }
+};
+
+// Index of each label's first command in the engine's flat script. A label
+// defined twice resolves to its last definition, as it did at runtime. Only
+// the liveStmts() of each label are emitted: the statements after its first
+// jump, choice or end never run and may name labels that were dropped.
+std::unordered_map<Symbol, uint32_t> labelStarts(const FlatProgram &program) {
+  std::unordered_map<Symbol, uint32_t> starts;
+  uint32_t offset = 0;
+  for (const FlatLabel &label : program.labels) {
+    starts[label.name] = offset;
+    offset += liveStmts(program, label).count;
+  }
+  return starts;
+}
+
+class StoryWriter {
+  const FlatProgram &program;
+  OutputBuffer out;
+  StringTable table;
+  // String ids of each dialogue, choice prompt and option, by flat index.
+  std::vector<uint32_t> dialogueText, choicePrompt, optionText;
+  std::unordered_map<Symbol, uint32_t> labelStart;
+
+  // Numbers the strings in the order the script first uses them.
+  void collectStrings() {
+    table.reserve(program.dialogues.size() + program.choices.size() +
+                  program.options.size());
+    dialogueText.resize(program.dialogues.size());
+    choicePrompt.resize(program.choices.size());
+    optionText.resize(program.options.size());
+    for (const FlatLabel &label : program.labels) {
+      Range live = liveStmts(program, label);
+      for (uint32_t i = live.first; i < live.end(); ++i) {
+        const Stmt &stmt = program.stmts[i];
+        if (stmt.kind == StmtKind::DIALOGUE) {
+          dialogueText[stmt.index] =
+              table.add(program.str(program.dialogues[stmt.index].text));
+        } else if (stmt.kind == StmtKind::CHOICE) {
+          const FlatChoice &choice = program.choices[stmt.index];
+          choicePrompt[stmt.index] = table.add(program.str(choice.prompt));
+          for (uint32_t o = choice.options.first; o < choice.options.end(); ++o)
+            optionText[o] = table.add(program.str(program.options[o].text));
+        }
+      }
+    }
+  }
+
+  static Indent pad(size_t width) { return {width}; }
+
+  void background(const FlatBackground &node) {
+    out << pad(6) << "\"" << nameOf(node.name) << "\": \""
+        << Escaped{absolutePath(program.str(node.imagePath))} << "\"";
+  }
+
+  void music(const FlatMusic &node) {
+    out << pad(6) << "\"" << nameOf(node.id) << "\": \""
+        << Escaped{absolutePath(program.str(node.filePath))} << "\"";
+  }
+
+  void character(const FlatCharacter &node) {
+    out << pad(6) << "\"" << nameOf(node.id) << "\": {\n";
+    out << pad(8) << "\"name\": \""
+        << Escaped{program.str(node.displayName)} << "\",\n";
+    out << pad(8) << "\"states\": {\n";
+    for (uint32_t i = node.modes.first; i < node.modes.end(); ++i) {
+      const FlatMode &mode = program.modes[i];
+      if (i != node.modes.first)
+        out << ",\n";
+      out << pad(10) << "\"" << nameOf(mode.name) << "\": { ";
+      out << "\"path\": \""
+          << Escaped{absolutePath(program.str(mode.imagePath))} << "\"";
+      const Parameters &parameters = program.parameters(mode.params);
+      if (parameters.has(Param::SCALE)) {
+        double scale = parameters.get(Param::SCALE);
+        out << ", \"scale\": [" << scale << ", " << scale << "]";
+      }
+      out << " }";
+    }
+    out << "\n" << pad(8) << "}\n";
+    out << pad(6) << "}";
+  }
+
+  void command(const Stmt &stmt) {
+    out << pad(8);
+    switch (stmt.kind) {
+    case StmtKind::SCENE: {
+      const FlatScene &node = program.scenes[stmt.index];
+      out << "{ \"command\": \"scene\", ";
+      out << "\"background\": \"" << nameOf(node.background) << "\" }";
+      break;
+    }
+    case StmtKind::SHOW: {
+      const FlatShow &node = program.shows[stmt.index];
+      out << "{ \"command\": \"show\", ";
+      out << "\"character\": \"" << nameOf(node.character) << "\", ";
+      out << "\"state\": \"" << nameOf(node.mode) << "\"";
+      const Parameters &parameters = program.parameters(node.params);
+      if (parameters.has(Param::X) || parameters.has(Param::Y)) {
+        out << ", \"position\": [" << parameters.get(Param::X) << ", "
+            << parameters.get(Param::Y) << "]";
+      }
+      out << " }";
+      break;
+    }
+    case StmtKind::HIDE: {
+      const FlatHide &node = program.hides[stmt.index];
+      out << "{ \"command\": \"hide\", ";
+      out << "\"character\": \"" << nameOf(node.character) << "\" }";
+      break;
+    }
+    case StmtKind::DIALOGUE: {
+      const FlatDialogue &node = program.dialogues[stmt.index];
+      out << "{ \"command\": \"dialogue\", ";
+      out << "\"speaker\": \"" << nameOf(node.speaker) << "\", ";
+      out << "\"text\": " << dialogueText[stmt.index];
+      const Parameters &parameters = program.parameters(node.params);
+      if (parameters.has(Param::SPEED))
+        out << ", \"speed\": " << parameters.get(Param::SPEED);
+      out << " }";
+      break;
+    }
+    case StmtKind::PLAY:
+      out << "{ \"command\": \"play\", ";
+      out << "\"music\": \"" << nameOf(program.plays[stmt.index].music)
+          << "\" }";
+      break;
+    case StmtKind::STOP:
+      out << "{ \"command\": \"stop\", ";
+      out << "\"music\": \"" << nameOf(program.stops[stmt.index].music)
+          << "\" }";
+      break;
+    case StmtKind::CHOICE: {
+      const FlatChoice &node = program.choices[stmt.index];
+      out << "{ \"command\": \"choice\", ";
+      out << "\"prompt\": " << choicePrompt[stmt.index] << ", ";
+      out << "\"options\": [\n";
+      for (uint32_t i = node.options.first; i < node.options.end(); ++i) {
+        const FlatOption &option = program.options[i];
+        if (i != node.options.first)
+          out << ",\n";
+        out << pad(12) << "{ ";
+        out << "\"text\": " << optionText[i] << ", ";
+        out << "\"goto\": " << labelStart.at(option.target) << " }";
+      }
+      out << "\n" << pad(10) << "]\n";
+      out << pad(8) << "}";
+      break;
+    }
+    case StmtKind::JUMP:
+      out << "{ \"command\": \"jump\", ";
+      out << "\"target\": " << labelStart.at(program.jumps[stmt.index].target)
+          << " }";
+      break;
+    case StmtKind::END:
+      out << "{\"command\": \"end\"}";
+      break;
+    }
+  }
+
+  void string(std::string_view s) {
+    out << pad(4) << "\"" << Escaped{s} << "\"";
+  }
+
+  void label(const FlatLabel &node) {
+    out << pad(4) << "{\n";
+    out << pad(6) << "\"label\": \"" << nameOf(node.name) << "\",\n";
+    out << pad(6) << "\"commands\": [\n";
+    Range live = liveStmts(program, node);
+    for (uint32_t i = live.first; i < live.end(); ++i) {
+      if (i != live.first)
+        out << ",\n";
+      command(program.stmts[i]);
+    }
+    out << "\n" << pad(6) << "]\n";
+    out << pad(4) << "}";
+  }
+
+  // Writes items separated by ",\n".
+  template <typename T, typename Write>
+  void list(const std::vector<T> &items, Write write) {
+    for (size_t i = 0; i < items.size(); ++i) {
+      if (i)
+        out << ",\n";
+      (this->*write)(items[i]);
+    }
+  }
+
+public:
+  StoryWriter(const FlatProgram &program, std::ostream &out)
+      : program(program), out(out), labelStart(labelStarts(program)) {
+    collectStrings();
+  }
+
+  void write() {
+    out << "{\n";
+    out << "  \"assets\": {\n";
+    out << "    \"backgrounds\": {\n";
+    list(program.backgrounds, &StoryWriter::background);
+    out << "\n    },\n";
+    out << "    \"music\": {\n";
+    list(program.music, &StoryWriter::music);
+    out << "\n    },\n";
+    out << "    \"characters\": {\n";
+    list(program.characters, &StoryWriter::character);
+    out << "\n    }\n";
+    out << "  },\n";
+    out << "  \"strings\": [\n";
+    list(table.all(), &StoryWriter::string);
+    out << "\n  ],\n";
+    out << "  \"script\": [\n";
+    list(program.labels, &StoryWriter::label);
+    out << "\n  ]\n";
+    out << "}\n";
+  }
+};
+
+constexpr bool sameOp(StmtKind kind, StoryOp op) {
+  return static_cast<uint32_t>(kind) == static_cast<uint32_t>(op);
+}
+
+static_assert(sameOp(StmtKind::SCENE, StoryOp::SCENE) &&
+                  sameOp(StmtKind::SHOW, StoryOp::SHOW) &&
+                  sameOp(StmtKind::HIDE, StoryOp::HIDE) &&
+                  sameOp(StmtKind::DIALOGUE, StoryOp::DIALOGUE) &&
+                  sameOp(StmtKind::PLAY, StoryOp::PLAY) &&
+                  sameOp(StmtKind::STOP, StoryOp::STOP) &&
+                  sameOp(StmtKind::CHOICE, StoryOp::CHOICE) &&
+                  sameOp(StmtKind::JUMP, StoryOp::JUMP) &&
+                  sameOp(StmtKind::END, StoryOp::END),
+              "command() casts each StmtKind to the StoryOp of its name");
+
+class BytecodeWriter {
+  static constexpr float DEFAULT_SPEED = 30.0f;
+
+  const FlatProgram &program;
+  StringTable table;
+  // Absolute asset paths, kept alive for the table's views.
+  std::deque<std::string> paths;
+  std::unordered_map<Symbol, uint32_t> labelStart;
+
+  std::vector<StoryAsset> backgrounds, music;
+  std::vector<StoryCharacter> characters;
+  std::vector<StoryMode> modes;
+  std::vector<StoryCommand> commands;
+  std::vector<StoryOption> options;
+
+  uint32_t name(Symbol symbol) { return table.add(nameOf(symbol)); }
+  uint32_t text(StrRef ref) { return table.add(program.str(ref)); }
+  uint32_t path(StrRef ref) {
+    return table.add(paths.emplace_back(absolutePath(program.str(ref))));
+  }
+
+  StoryCommand command(const Stmt &stmt) {
+    StoryCommand cmd{static_cast<StoryOp>(stmt.kind), 0, 0, 0, 0, 0};
+    switch (stmt.kind) {
+    case StmtKind::SCENE:
+      cmd.a = name(program.scenes[stmt.index].background);
+      break;
+    case StmtKind::SHOW: {
+      const FlatShow &node = program.shows[stmt.index];
+      const Parameters &parameters = program.parameters(node.params);
+      cmd.a = name(node.character);
+      cmd.b = name(node.mode);
+      cmd.x = static_cast<float>(parameters.get(Param::X));
+      cmd.y = static_cast<float>(parameters.get(Param::Y));
+      break;
+    }
+    case StmtKind::HIDE:
+      cmd.a = name(program.hides[stmt.index].character);
+      break;
+    case StmtKind::DIALOGUE: {
+      const FlatDialogue &node = program.dialogues[stmt.index];
+      const Parameters &parameters = program.parameters(node.params);
+      cmd.a = name(node.speaker);
+      cmd.b = text(node.text);
+      cmd.x = parameters.has(Param::SPEED)
+                  ? static_cast<float>(parameters.get(Param::SPEED))
+                  : DEFAULT_SPEED;
+      break;
+    }
+    case StmtKind::PLAY:
+      cmd.a = name(program.plays[stmt.index].music);
+      break;
+    case StmtKind::STOP:
+      cmd.a = name(program.stops[stmt.index].music);
+      break;
+    case StmtKind::CHOICE: {
+      const FlatChoice &node = program.choices[stmt.index];
+      cmd.a = text(node.prompt);
+      cmd.b = static_cast<uint32_t>(options.size());
+      cmd.c = node.options.count;
+      for (uint32_t i = node.options.first; i < node.options.end(); ++i) {
+        const FlatOption &option = program.options[i];
+        options.push_back({text(option.text), labelStart.at(option.target)});
+      }
+      break;
+    }
+    case StmtKind::JUMP:
+      cmd.a = labelStart.at(program.jumps[stmt.index].target);
+      break;
+    case StmtKind::END:
+      break;
+    }
+    return cmd;
+  }
+
+  void collect() {
+    for (const FlatBackground &node : program.backgrounds)
+      backgrounds.push_back({name(node.name), path(node.imagePath)});
+    for (const FlatMusic &node : program.music)
+      music.push_back({name(node.id), path(node.filePath)});
+    for (const FlatCharacter &node : program.characters) {
+      characters.push_back({name(node.id), text(node.displayName),
+                            static_cast<uint32_t>(modes.size()),
+                            node.modes.count});
+      for (uint32_t i = node.modes.first; i < node.modes.end(); ++i) {
+        const FlatMode &mode = program.modes[i];
+        const Parameters &parameters = program.parameters(mode.params);
+        float scale = parameters.has(Param::SCALE)
+                          ? static_cast<float>(parameters.get(Param::SCALE))
+                          : 1.0f;
+        modes.push_back({name(mode.name), path(mode.imagePath), scale, scale});
+      }
+    }
+    for (const FlatLabel &label : program.labels) {
+      Range live = liveStmts(program, label);
+      for (uint32_t i = live.first; i < live.end(); ++i)
+        commands.push_back(command(program.stmts[i]));
+    }
+  }
+
+  template <typename T> void put(std::ostream &out, const std::vector<T> &v) {
+    out.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+  }
+
+public:
+  explicit BytecodeWriter(const FlatProgram &program)
+      : program(program), labelStart(labelStarts(program)) {
+    collect();
+  }
+
+  void write(std::ostream &out) {
+    const std::vector<std::string_view> &strings = table.all();
+    std::vector<StoryString> entries;
+    entries.reserve(strings.size());
+    uint32_t textBytes = 0;
+    for (std::string_view s : strings) {
+      entries.push_back({textBytes, static_cast<uint32_t>(s.size())});
+      textBytes += static_cast<uint32_t>(s.size());
+    }
+
+    auto start = labelStart.find(intern("start"));
+    StoryHeader header{{STORY_MAGIC[0], STORY_MAGIC[1], STORY_MAGIC[2],
+                        STORY_MAGIC[3]},
+                       STORY_VERSION,
+                       static_cast<uint32_t>(entries.size()),
+                       static_cast<uint32_t>(backgrounds.size()),
+                       static_cast<uint32_t>(music.size()),
+                       static_cast<uint32_t>(characters.size()),
+                       static_cast<uint32_t>(modes.size()),
+                       static_cast<uint32_t>(commands.size()),
+                       static_cast<uint32_t>(options.size()),
+                       textBytes,
+                       start != labelStart.end() ? start->second
+                                                 : STORY_NO_ENTRY};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    put(out, entries);
+    put(out, backgrounds);
+    put(out, music);
+    put(out, characters);
+    put(out, modes);
+    put(out, commands);
+    put(out, options);
+    for (std::string_view s : strings)
+      out.write(s.data(), s.size());
+  }
+};
+
+} // namespace
+
+std::string_view engineIncludes() { return ENGINE_INCLUDES; }
+
+std::string engineSource(const std::string &compilerPath) {
+  std::ostringstream source;
+  generateEngineCode(source, compilerPath);
+  return source.str();
+}
+
+void generateStory(const FlatProgram &program, std::ostream &out) {
+  StoryWriter(program, out).write();
+}
+
+void generateBytecode(const FlatProgram &program, std::ostream &out) {
+  BytecodeWriter(program).write(out);
+}
+
+void generateStorySource(std::string_view bytecode, std::ostream &stream) {
+  constexpr size_t BYTES_PER_LINE = 64;
+  OutputBuffer out(stream);
+  out << "#include <cstddef>\n\n";
+  out << "alignas(4) extern const char STORY_DATA["
+      << static_cast<uint32_t>(bytecode.size() + 1) << "] =\n";
+  for (size_t i = 0; i < bytecode.size(); i += BYTES_PER_LINE) {
+    out << "    \"";
+    for (char c : bytecode.substr(i, BYTES_PER_LINE)) {
+      unsigned char byte = static_cast<unsigned char>(c);
+      if (byte >= 0x20 && byte < 0x7f && c != '"' && c != '\\' && c != '?') {
+        out << c;
+      } else {
+        char octal[5] = {'\\', char('0' + (byte >> 6)),
+                         char('0' + ((byte >> 3) & 7)), char('0' + (byte & 7)),
+                         0};
+        out << std::string_view(octal, 4);
+      }
+    }
+    out << "\"\n";
+  }
+  if (bytecode.empty())
+    out << "    \"\"\n";
+  out << "    ;\n";
+  out << "extern const size_t STORY_SIZE = "
+      << static_cast<uint32_t>(bytecode.size()) << ";\n";
+}
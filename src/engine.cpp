@@ -0,0 +1,169 @@
+#include <codegen.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <engine.hpp>
+#include <filesystem>
+#include <fstream>
+#include <hash.hpp>
+#include <lru.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <trace.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char *ENGINE_FLAGS = "-std=c++17";
+constexpr const char *ENGINE_LIBS =
+    "-lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio";
+// Engines kept in the cache: the player and embedded builds of this compiler
+// and of the one before it.
+constexpr size_t MAX_ENGINES = 4;
+
+std::string engineFile(const std::string &engineDir, uint64_t hash,
+                       EngineBuild build) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "juego_%016llx%s",
+                static_cast<unsigned long long>(hash),
+                build == EngineBuild::EMBEDDED ? ".o" : "");
+  return engineDir + "/" + name;
+}
+
+// Whether pch is newer than every header listed in the dependency file g++
+// wrote when building it.
+bool upToDate(const std::string &pch, const std::string &depsPath) {
+  std::error_code ec;
+  auto built = fs::last_write_time(pch, ec);
+  if (ec)
+    return false;
+  std::ifstream deps(depsPath);
+  if (!deps.is_open())
+    return false;
+  std::string word;
+  // The first word is the rule's target.
+  deps >> word;
+  while (deps >> word) {
+    if (word == "\\")
+      continue;
+    auto changed = fs::last_write_time(word, ec);
+    if (ec || changed > built)
+      return false;
+  }
+  return true;
+}
+
+// Returns the flag that makes g++ use the precompiled engine headers, built
+// in tmpPath/pch when missing or older than the headers it includes. When it
+// cannot be built the engine is compiled without it, and the attempt is not
+// repeated until the header changes; its errors are left for the engine
+// compile to report. The header is the engine source's own #include block,
+// so the two cannot drift apart.
+std::string precompiledHeader(const std::string &tmpPath) {
+  TraceSpan span("precompile headers");
+  std::string dir = tmpPath + "/pch";
+  std::string header = dir + "/juego_pch.hpp";
+  std::string pch = header + ".gch";
+  std::string deps = dir + "/juego_pch.d";
+  // Present while the current header is known not to precompile.
+  std::string failed = dir + "/juego_pch.failed";
+
+  std::ifstream current(header);
+  std::ostringstream text;
+  text << current.rdbuf();
+  current.close();
+  std::error_code ec;
+  if (text.str() == engineIncludes()) {
+    if (upToDate(pch, deps))
+      return " -include " + header;
+    if (fs::exists(failed, ec))
+      return "";
+  }
+
+  fs::create_directories(dir);
+  if (text.str() != engineIncludes()) {
+    fs::remove(failed, ec);
+    std::ofstream file(header);
+    if (!file.is_open()) {
+      throw std::runtime_error("No se pudo abrir " + header +
+                               " para escribir.");
+    }
+    file << engineIncludes();
+  }
+  std::string tmp = pch + ".tmp";
+  std::string command = std::string("g++ ") + ENGINE_FLAGS +
+                        " -x c++-header " + header + " -o " + tmp +
+                        " -MD -MF " + deps + " > /dev/null 2>&1";
+  if (std::system(command.c_str()) != 0) {
+    fs::remove(tmp, ec);
+    std::ofstream marker(failed);
+    return "";
+  }
+  fs::rename(tmp, pch);
+  return " -include " + header;
+}
+
+void compile(const std::string &command) {
+  int result;
+  {
+    TraceSpan span("compile engine");
+    result = std::system(command.c_str());
+  }
+  if (result != 0)
+    throw std::runtime_error("Falló la compilación del juego.");
+}
+
+} // namespace
+
+std::string buildEngine(const std::string &compilerPath, EngineBuild build) {
+  std::string tmpPath = compilerPath + "/.tmp";
+  std::string engineDir = tmpPath + "/engine";
+  std::string source = engineSource(compilerPath);
+  std::string flags = ENGINE_FLAGS;
+  if (build == EngineBuild::EMBEDDED)
+    flags += " -DSTORY_EMBEDDED -c";
+  else
+    flags += std::string(" ") + ENGINE_LIBS;
+  uint64_t hash = fnv1a(flags, fnv1a(source));
+  std::string engine = engineFile(engineDir, hash, build);
+
+  std::error_code ec;
+  if (fs::exists(engine, ec)) {
+    traceCount("cached engines", 1);
+    markUsed(engine);
+    return engine;
+  }
+
+  std::string sourcePath = tmpPath + "/juego_generado.cpp";
+  {
+    std::ofstream file(sourcePath);
+    if (!file.is_open()) {
+      throw std::runtime_error("No se pudo abrir " + sourcePath +
+                               " para escribir.");
+    }
+    file << source;
+  }
+  traceCount("bytes written", source.size());
+  fs::create_directories(engineDir);
+
+  // Built under a temporary name so an interrupted build is never reused.
+  std::string tmp = engine + ".tmp";
+  try {
+    compile("g++ " + sourcePath + " -o " + tmp + " " + flags +
+            precompiledHeader(tmpPath));
+  } catch (...) {
+    fs::remove(tmp, ec);
+    throw;
+  }
+  fs::rename(tmp, engine);
+  evictLeastRecentlyUsed(engineDir, MAX_ENGINES);
+  return engine;
+}
+
+void linkEmbeddedGame(const std::string &compilerPath,
+                      const std::string &storySource,
+                      const std::string &output) {
+  std::string engine = buildEngine(compilerPath, EngineBuild::EMBEDDED);
+  compile(std::string("g++ ") + ENGINE_FLAGS + " -o " + output + " " +
+          engine + " " + storySource + " " + ENGINE_LIBS);
+}
@@ -0,0 +1,164 @@
+#include <flat_ast.hpp>
+#include <stdexcept>
+
+namespace {
+
+class Flattener {
+  FlatProgram &flat;
+
+  StrRef add(std::string_view s) {
+    StrRef ref{static_cast<uint32_t>(flat.strings.size()),
+               static_cast<uint32_t>(s.size())};
+    flat.strings.append(s);
+    return ref;
+  }
+
+  ParamsId add(const Parameters &parameters) {
+    if (!parameters.present)
+      return {};
+    flat.params.push_back(parameters);
+    return {static_cast<uint32_t>(flat.params.size() - 1)};
+  }
+
+  template <typename T> uint32_t push(std::vector<T> &array, T value) {
+    array.push_back(value);
+    return static_cast<uint32_t>(array.size() - 1);
+  }
+
+  Stmt stmt(const ASTNode &node) {
+    switch (node.kind) {
+    case NodeKind::SCENE: {
+      auto &n = static_cast<const SceneNode &>(node);
+      return {StmtKind::SCENE, push(flat.scenes, {n.name, add(n.parameters)})};
+    }
+    case NodeKind::SHOW: {
+      auto &n = static_cast<const ShowNode &>(node);
+      return {StmtKind::SHOW,
+              push(flat.shows, {n.characterId, n.mode, add(n.parameters)})};
+    }
+    case NodeKind::HIDE: {
+      auto &n = static_cast<const HideNode &>(node);
+      return {StmtKind::HIDE,
+              push(flat.hides, {n.characterId, add(n.parameters)})};
+    }
+    case NodeKind::DIALOGUE: {
+      auto &n = static_cast<const DialogueNode &>(node);
+      return {StmtKind::DIALOGUE,
+              push(flat.dialogues,
+                   {n.speaker, add(n.text), add(n.parameters)})};
+    }
+    case NodeKind::PLAY:
+      return {StmtKind::PLAY,
+              push(flat.plays,
+                   {static_cast<const PlayNode &>(node).musicId})};
+    case NodeKind::STOP:
+      return {StmtKind::STOP,
+              push(flat.stops,
+                   {static_cast<const StopNode &>(node).musicId})};
+    case NodeKind::CHOICE: {
+      auto &n = static_cast<const ChoiceNode &>(node);
+      FlatChoice choice{add(n.prompt),
+                        {static_cast<uint32_t>(flat.options.size()),
+                         static_cast<uint32_t>(n.options.size())}};
+      for (const OptionNode *option : n.options)
+        flat.options.push_back({add(option->text), option->gotoLabel});
+      return {StmtKind::CHOICE, push(flat.choices, choice)};
+    }
+    case NodeKind::JUMP:
+      return {StmtKind::JUMP,
+              push(flat.jumps, {static_cast<const JumpNode &>(node).target})};
+    case NodeKind::END:
+      return {StmtKind::END, 0};
+    default:
+      throw std::logic_error("Sentencia sin forma plana");
+    }
+  }
+
+public:
+  explicit Flattener(FlatProgram &flat) : flat(flat) {}
+
+  void topLevel(const ASTNode &node) {
+    switch (node.kind) {
+    case NodeKind::BACKGROUND: {
+      auto &n = static_cast<const BackgroundNode &>(node);
+      flat.backgrounds.push_back({n.name, add(n.imagePath)});
+      break;
+    }
+    case NodeKind::MUSIC: {
+      auto &n = static_cast<const MusicNode &>(node);
+      flat.music.push_back({n.id, add(n.filePath)});
+      break;
+    }
+    case NodeKind::CHARACTER: {
+      auto &n = static_cast<const CharacterNode &>(node);
+      FlatCharacter character{n.id, add(n.displayName),
+                              {static_cast<uint32_t>(flat.modes.size()),
+                               static_cast<uint32_t>(n.modes.size())}};
+      for (const CharacterModeData *mode : n.modes) {
+        flat.modes.push_back(
+            {mode->name, add(mode->imagePath), add(mode->parameters)});
+      }
+      flat.characters.push_back(character);
+      break;
+    }
+    case NodeKind::LABEL: {
+      auto &n = static_cast<const LabelNode &>(node);
+      // A label's range must be contiguous, so its statements are added
+      // before anything else touches stmts.
+      FlatLabel label{n.name,
+                      {static_cast<uint32_t>(flat.stmts.size()),
+                       static_cast<uint32_t>(n.statements.size())}};
+      for (const ASTNode *inner : n.statements)
+        flat.stmts.push_back(stmt(*inner));
+      flat.labels.push_back(label);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+};
+
+template <typename T> size_t arrayBytes(const std::vector<T> &array) {
+  return array.capacity() * sizeof(T);
+}
+
+} // namespace
+
+size_t FlatProgram::bytes() const {
+  return arrayBytes(backgrounds) + arrayBytes(music) + arrayBytes(characters) +
+         arrayBytes(modes) + arrayBytes(labels) + arrayBytes(stmts) +
+         arrayBytes(scenes) + arrayBytes(shows) + arrayBytes(hides) +
+         arrayBytes(dialogues) + arrayBytes(plays) + arrayBytes(stops) +
+         arrayBytes(choices) + arrayBytes(options) + arrayBytes(jumps) +
+         arrayBytes(params) + strings.capacity();
+}
+
+void FlatProgram::shrinkToFit() {
+  backgrounds.shrink_to_fit();
+  music.shrink_to_fit();
+  characters.shrink_to_fit();
+  modes.shrink_to_fit();
+  labels.shrink_to_fit();
+  stmts.shrink_to_fit();
+  scenes.shrink_to_fit();
+  shows.shrink_to_fit();
+  hides.shrink_to_fit();
+  dialogues.shrink_to_fit();
+  plays.shrink_to_fit();
+  stops.shrink_to_fit();
+  choices.shrink_to_fit();
+  options.shrink_to_fit();
+  jumps.shrink_to_fit();
+  params.shrink_to_fit();
+  strings.shrink_to_fit();
+}
+
+FlatProgram flatten(const ProgramNode &program) {
+  FlatProgram flat;
+  Flattener flattener(flat);
+  for (const ASTNode *stmt : program.statements)
+    flattener.topLevel(*stmt);
+  flat.shrinkToFit();
+  return flat;
+}
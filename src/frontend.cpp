@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <frontend.hpp>
+#include <hash.hpp>
+#include <lexer.hpp>
+#include <module.hpp>
+#include <parser.hpp>
+#include <scan.hpp>
+#include <source.hpp>
+#include <string_view>
+#include <thread>
+#include <trace.hpp>
+#include <vector>
+
+namespace {
+
+constexpr size_t PARALLEL_MIN_BYTES = 256 * 1024;
+
+struct LabelLine {
+  size_t offset;
+  int line;
+};
+
+struct ScriptLayout {
+  std::vector<LabelLine> labels;
+  bool imports = false;
+};
+
+struct ChunkResult {
+  NodeList statements;
+  std::unique_ptr<Arena> arena;
+  SymbolTable symbols;
+  std::exception_ptr error;
+};
+
+bool isWordChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool startsWord(std::string_view text, size_t i, std::string_view word) {
+  if (text.compare(i, word.size(), word) != 0)
+    return false;
+  size_t next = i + word.size();
+  return next == text.size() || !isWordChar(text[next]);
+}
+
+// Finds the `label` keywords that open a line and any `import`, skipping over
+// strings and comments the same way the lexer does.
+ScriptLayout scanLayout(std::string_view text) {
+  ScriptLayout layout;
+  const char *base = text.data();
+  const char *end = base + text.size();
+  const char *p = base;
+  int line = 1;
+  bool lineStart = true;
+
+  while (p < end) {
+    if (lineStart) {
+      while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+      lineStart = false;
+      size_t i = p - base;
+      if (startsWord(text, i, "label"))
+        layout.labels.push_back({i, line});
+      continue;
+    }
+
+    switch (*p) {
+    case '\n':
+      ++line;
+      lineStart = true;
+      ++p;
+      break;
+    case '#':
+      p = scanLine(p, end);
+      break;
+    case '"':
+      ++p;
+      while (p < end) {
+        p = scanString(p, end);
+        if (p == end)
+          break;
+        if (*p == '"') {
+          ++p;
+          break;
+        }
+        if (*p == '\\' && p + 1 < end)
+          ++p;
+        if (*p == '\n')
+          ++line;
+        ++p;
+      }
+      break;
+    case 'i':
+      if ((p == base || !isWordChar(p[-1])) &&
+          startsWord(text, p - base, "import"))
+        layout.imports = true;
+      ++p;
+      break;
+    default:
+      ++p;
+      break;
+    }
+  }
+  return layout;
+}
+
+std::unique_ptr<ProgramNode> parseSerial(std::string_view text,
+                                         const std::string &compilerPath) {
+  TraceSpan span("parse");
+  Lexer lexer(text);
+  Parser parser(lexer, compilerPath);
+  std::unique_ptr<ProgramNode> program = parser.parseProgram();
+  traceCount("tokens", lexer.tokenCount());
+  return program;
+}
+
+// Parses the label blocks in text, which starts at line firstLine, against the
+// assets that the prelude defined.
+void parseLabels(std::string_view text, int firstLine,
+                 const SymbolTable &assets, const std::string &compilerPath,
+                 ChunkResult &result) {
+  TraceSpan span("parse labels", "línea " + std::to_string(firstLine));
+  try {
+    Lexer lexer(text, firstLine);
+    Parser parser(lexer, compilerPath);
+    SymbolTable &table = parser.symbolTable();
+    table.backgrounds = assets.backgrounds;
+    table.characters = assets.characters;
+    table.music = assets.music;
+    parser.parseStatements(result.statements);
+    traceCount("tokens", lexer.tokenCount());
+    result.symbols = std::move(parser.symbolTable());
+    result.arena = parser.releaseArena();
+  } catch (...) {
+    result.error = std::current_exception();
+  }
+}
+
+} // namespace
+
+std::unique_ptr<ProgramNode> parseScript(const char *path,
+                                         const std::string &compilerPath,
+                                         unsigned jobs) {
+  SourceFile source(path);
+  std::string_view text = source.text();
+
+  ScriptLayout layout;
+  {
+    TraceSpan span("scan layout");
+    layout = scanLayout(text);
+  }
+  if (layout.imports)
+    return parseModules(path, text, compilerPath, jobs);
+
+  if (jobs <= 1 || text.size() < PARALLEL_MIN_BYTES ||
+      layout.labels.size() < 2) {
+    std::unique_ptr<ProgramNode> program = parseSerial(text, compilerPath);
+    program->sourceHash = fnv1a(text);
+    if (std::strcmp(path, "-") != 0)
+      program->sources.push_back(path);
+    return program;
+  }
+
+  const std::vector<LabelLine> &labels = layout.labels;
+  size_t chunks = std::min<size_t>(jobs, labels.size());
+  size_t target = (text.size() - labels.front().offset) / chunks;
+  std::vector<size_t> bounds{0};
+  for (size_t i = 1; i < labels.size() && bounds.size() < chunks; ++i) {
+    if (labels[i].offset - labels[bounds.back()].offset >= target)
+      bounds.push_back(i);
+  }
+
+  auto program = std::make_unique<ProgramNode>(compilerPath);
+  Lexer preludeLexer(text.substr(0, labels.front().offset));
+  Parser prelude(preludeLexer, compilerPath);
+  {
+    TraceSpan span("parse assets");
+    prelude.parseStatements(program->statements);
+    traceCount("tokens", preludeLexer.tokenCount());
+  }
+  program->arenas.push_back(prelude.releaseArena());
+  SymbolTable &symbols = prelude.symbolTable();
+
+  std::vector<ChunkResult> results(bounds.size());
+  auto parseChunk = [&](size_t k) {
+    const LabelLine &first = labels[bounds[k]];
+    size_t stop =
+        k + 1 < bounds.size() ? labels[bounds[k + 1]].offset : text.size();
+    parseLabels(text.substr(first.offset, stop - first.offset), first.line,
+                symbols, compilerPath, results[k]);
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t k = 1; k < bounds.size(); ++k)
+    workers.emplace_back(parseChunk, k);
+  parseChunk(0);
+  for (auto &worker : workers)
+    worker.join();
+
+  for (ChunkResult &result : results) {
+    if (result.error)
+      std::rethrow_exception(result.error);
+  }
+
+  TraceSpan span("merge labels");
+  for (ChunkResult &result : results) {
+    program->statements.insert(program->statements.end(),
+                               result.statements.begin(),
+                               result.statements.end());
+    program->arenas.push_back(std::move(result.arena));
+    symbols.labels.insertAll(result.symbols.labels);
+    symbols.jumpTargets.insert(symbols.jumpTargets.end(),
+                               result.symbols.jumpTargets.begin(),
+                               result.symbols.jumpTargets.end());
+  }
+  checkJumpTargets(symbols);
+
+  program->sourceHash = fnv1a(text);
+  if (std::strcmp(path, "-") != 0)
+    program->sources.push_back(path);
+  return program;
+}
+
+std::unique_ptr<ProgramNode> IncrementalParser::parse(const char *path) {
+  SourceFile source(path, SourceFile::Mode::READ);
+  std::string_view text = source.text();
+
+  ScriptLayout layout;
+  {
+    TraceSpan span("scan layout");
+    layout = scanLayout(text);
+  }
+  if (layout.imports) {
+    segments.clear();
+    return parseModules(path, text, compilerPath, jobs,
+                        SourceFile::Mode::READ);
+  }
+
+  const std::vector<LabelLine> &labels = layout.labels;
+  std::string_view assets =
+      text.substr(0, labels.empty() ? text.size() : labels.front().offset);
+  auto program = std::make_unique<ProgramNode>(compilerPath);
+  Lexer preludeLexer(assets);
+  Parser prelude(preludeLexer, compilerPath);
+  {
+    TraceSpan span("parse assets");
+    prelude.parseStatements(program->statements);
+    traceCount("tokens", preludeLexer.tokenCount());
+  }
+  program->arenas.push_back(prelude.releaseArena());
+  SymbolTable &symbols = prelude.symbolTable();
+  uint64_t assetsHash = fnv1a(assets);
+  if (assetsHash != preludeHash) {
+    segments.clear();
+    preludeHash = assetsHash;
+  }
+
+  struct Slice {
+    std::string_view text;
+    int line;
+    uint64_t hash;
+    std::shared_ptr<const Segment> segment;
+  };
+  std::vector<Slice> slices;
+  size_t first = 0;
+  for (size_t i = 0; i < labels.size(); ++i) {
+    size_t stop = i + 1 < labels.size() ? labels[i + 1].offset : text.size();
+    std::string_view header =
+        text.substr(labels[i].offset, stop - labels[i].offset);
+    header = header.substr(0, header.find('\n'));
+    if (stop != text.size() && fnv1a(header) % SEGMENT_LABELS != 0)
+      continue;
+    std::string_view slice =
+        text.substr(labels[first].offset, stop - labels[first].offset);
+    slices.push_back({slice, labels[first].line, fnv1a(slice), nullptr});
+    first = i + 1;
+  }
+
+  std::vector<size_t> missing;
+  for (size_t k = 0; k < slices.size(); ++k) {
+    auto cached = segments.find(slices[k].hash);
+    if (cached != segments.end() &&
+        cached->second->size == slices[k].text.size())
+      slices[k].segment = cached->second;
+    else
+      missing.push_back(k);
+  }
+  traceCount("reused segments", slices.size() - missing.size());
+
+  std::vector<ChunkResult> results(missing.size());
+  std::atomic<size_t> next{0};
+  auto parseMissing = [&] {
+    for (size_t m; (m = next++) < missing.size();) {
+      const Slice &slice = slices[missing[m]];
+      parseLabels(slice.text, slice.line, symbols, compilerPath, results[m]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t w = 1; w < std::min<size_t>(jobs, missing.size()); ++w)
+    workers.emplace_back(parseMissing);
+  parseMissing();
+  for (auto &worker : workers)
+    worker.join();
+
+  for (ChunkResult &result : results) {
+    if (result.error)
+      std::rethrow_exception(result.error);
+  }
+  for (size_t m = 0; m < missing.size(); ++m) {
+    auto segment = std::make_shared<Segment>();
+    segment->size = slices[missing[m]].text.size();
+    segment->arena = std::move(results[m].arena);
+    segment->statements = std::move(results[m].statements);
+    for (const ASTNode *stmt : segment->statements) {
+      if (auto label = nodeAs<LabelNode>(*stmt))
+        segment->labels.push_back(label->name);
+    }
+    segment->jumpTargets = std::move(results[m].symbols.jumpTargets);
+    slices[missing[m]].segment = std::move(segment);
+  }
+
+  TraceSpan span("merge labels");
+  segments.clear();
+  for (const Slice &slice : slices) {
+    const Segment &segment = *slice.segment;
+    program->statements.insert(program->statements.end(),
+                               segment.statements.begin(),
+                               segment.statements.end());
+    program->arenas.push_back(segment.arena);
+    for (Symbol label : segment.labels)
+      symbols.labels.insert(label);
+    symbols.jumpTargets.insert(symbols.jumpTargets.end(),
+                               segment.jumpTargets.begin(),
+                               segment.jumpTargets.end());
+    segments.emplace(slice.hash, slice.segment);
+  }
+  checkJumpTargets(symbols);
+
+  program->sourceHash = fnv1a(text);
+  if (std::strcmp(path, "-") != 0)
+    program->sources.push_back(path);
+  return program;
+}
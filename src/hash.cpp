@@ -0,0 +1,7 @@
+#include <hash.hpp>
+#include <source.hpp>
+
+uint64_t compilerHash() {
+  static const uint64_t hash = fnv1a(SourceFile("/proc/self/exe").text());
+  return hash;
+}
@@ -0,0 +1,62 @@
+#include <cstring>
+#include <interner.hpp>
+#include <tuple>
+
+StringInterner::StringInterner() {
+  names.emplace_back();
+  ids.emplace(std::string_view(), 0);
+}
+
+std::string_view StringInterner::store(std::string_view s) {
+  if (s.size() > BLOCK_SIZE / 4) {
+    blocks.push_back(std::make_unique<char[]>(s.size()));
+    std::memcpy(blocks.back().get(), s.data(), s.size());
+    return {blocks.back().get(), s.size()};
+  }
+  if (blockUsed + s.size() > BLOCK_SIZE) {
+    blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+    block = blocks.back().get();
+    blockUsed = 0;
+  }
+  char *dst = block + blockUsed;
+  std::memcpy(dst, s.data(), s.size());
+  blockUsed += s.size();
+  return {dst, s.size()};
+}
+
+Symbol StringInterner::intern(std::string_view s) {
+  // Symbols this thread has seen, keyed by the interner's own copy of the
+  // name so entries stay valid after the source is unmapped. Repeated names
+  // are resolved without touching the shared lock.
+  thread_local std::unordered_map<std::string_view, Symbol> seen;
+  auto cached = seen.find(s);
+  if (cached != seen.end())
+    return cached->second;
+
+  std::string_view stored;
+  Symbol id = 0;
+  bool found = false;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(s);
+    if (it != ids.end()) {
+      std::tie(stored, id) = *it;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(s);
+    if (it != ids.end()) {
+      std::tie(stored, id) = *it;
+    } else {
+      stored = store(s);
+      id = static_cast<Symbol>(names.size());
+      names.push_back(stored);
+      ids.emplace(stored, id);
+    }
+  }
+  seen.emplace(stored, id);
+  return id;
+}
@@ -1,68 +1,49 @@
 #include "token.hpp"
 #include <cctype>
-#include <fcntl.h>
 #include <lexer.hpp>
-#include <unistd.h>
+#include <scan.hpp>
 
-Lexer::Lexer(const char *path) {
-  fd = open(path, O_RDONLY);
-  if (fd < 0) {
-    perror("open");
-    exit(1);
-  }
+Lexer::Lexer(const char *path) : source(std::make_unique<SourceFile>(path)) {
+  std::string_view text = source->text();
+  pos = text.data();
+  end = text.data() + text.size();
   advance();
 }
 
-Lexer::~Lexer() {
-  if (fd >= 0)
-    close(fd);
+Lexer::Lexer(std::string_view text, int firstLine)
+    : pos(text.data()), end(text.data() + text.size()), line(firstLine) {
+  advance();
 }
 
 void Lexer::advance() {
-  if (bufferPos >= bufferLen) {
-    bufferLen = read(fd, buffer, BUFFER_SIZE);
-    bufferPos = 0;
-    if (bufferLen <= 0) {
-      endOfFile = true;
-      currentChar = 0;
-      return;
-    }
-  }
-  currentChar = buffer[bufferPos++];
-}
-Token Lexer::peekToken(size_t n) {
-  while (bufferToken.size() < n) {
-    bufferToken.push_back(realNextToken());
+  if (pos >= end) {
+    endOfFile = true;
+    currentChar = 0;
+    return;
   }
-  return bufferToken[n - 1];
+  currentChar = *pos++;
 }
 
 Token Lexer::nextToken() {
-  if (!bufferToken.empty()) {
-    Token tok = bufferToken.front();
-    bufferToken.pop_front();
-    return tok;
-  }
+  ++tokensRead;
   return realNextToken();
 }
 
 Token Lexer::realNextToken() {
-  std::string lexeme;
+  const char *start = nullptr;
   State state = State::START;
 
   while (!endOfFile) {
     switch (state) {
     case State::START:
       if (std::isspace(currentChar)) {
-        if (currentChar == '\n')
-          ++line;
-        advance();
+        skipTo(skipSpace(mark(), end, line));
       } else if (std::isalpha(currentChar) || currentChar == '_') {
-        lexeme += currentChar;
+        start = mark();
         advance();
         state = State::IDENTIFIER;
       } else if (std::isdigit(currentChar)) {
-        lexeme += currentChar;
+        start = mark();
         advance();
         state = State::NUMBER;
       } else if (currentChar == '"') {
@@ -71,14 +52,13 @@ Token Lexer::realNextToken() {
       } else if (currentChar == '#') {
         advance();
 
-        while (!endOfFile && currentChar != '\n') {
-          lexeme += currentChar;
-          advance();
-        }
+        start = mark();
+        skipTo(scanLine(start, end));
 
-        return {TokenType::COMMENT, lexeme, line};
+        return {TokenType::COMMENT, {start, size_t(mark() - start)}, line};
       } else {
         TokenType type;
+        std::string_view val(mark(), 1);
         switch (currentChar) {
         case ':':
           type = TokenType::COLON;
@@ -101,118 +81,118 @@ Token Lexer::realNextToken() {
         case '-':
           advance();
           if (std::isdigit(currentChar)) {
-            lexeme += currentChar;
+            start = mark();
             advance();
             state = State::NUMBER;
             continue;
           } else if (currentChar == '>') {
             type = TokenType::ARROW;
-            lexeme = "->";
+            val = {val.data(), 2};
           } else {
             type = TokenType::UNKNOWN;
-            lexeme = "-";
           }
           break;
         default:
           type = TokenType::UNKNOWN;
           break;
         }
-        std::string val;
-        if (lexeme.empty()) {
-          val = std::string(1, currentChar);
-        } else {
-          val = lexeme;
-        }
         advance();
         return {type, val, line};
       }
       break;
 
-    case State::IDENTIFIER:
+    case State::IDENTIFIER: {
       while (std::isalnum(currentChar) || currentChar == '_') {
-        lexeme += currentChar;
         advance();
       }
 
-      if (lexeme == "background")
-        return {TokenType::BACKGROUND, lexeme, line};
-      if (lexeme == "define")
-        return {TokenType::DEFINE, lexeme, line};
-      if (lexeme == "show")
-        return {TokenType::SHOW, lexeme, line};
-      if (lexeme == "scene")
-        return {TokenType::SCENE, lexeme, line};
-      if (lexeme == "hide")
-        return {TokenType::HIDE, lexeme, line};
-      if (lexeme == "music")
-        return {TokenType::MUSIC, lexeme, line};
-      if (lexeme == "play")
-        return {TokenType::PLAY, lexeme, line};
-      if (lexeme == "stop")
-        return {TokenType::STOP, lexeme, line};
-      if (lexeme == "choice")
-        return {TokenType::CHOICE, lexeme, line};
-      if (lexeme == "option")
-        return {TokenType::OPTION, lexeme, line};
-      if (lexeme == "label")
-        return {TokenType::LABEL, lexeme, line};
-      if (lexeme == "jump")
-        return {TokenType::JUMP, lexeme, line};
-      if (lexeme == "end")
-        return {TokenType::END, lexeme, line};
-      return {TokenType::IDENTIFIER, lexeme, line};
+      std::string_view lexeme(start, mark() - start);
+      TokenType type = keywordType(lexeme);
+      if (type != TokenType::IDENTIFIER)
+        return {type, lexeme, line};
+      return {TokenType::IDENTIFIER, lexeme, line, intern(lexeme)};
+    }
 
     case State::NUMBER: {
       bool hasDot = false;
       while (std::isdigit(currentChar) || (!hasDot && currentChar == '.')) {
         if (currentChar == '.')
           hasDot = true;
-        lexeme += currentChar;
         advance();
       }
-      return {hasDot ? TokenType::FLOAT : TokenType::INT, lexeme, line};
+      return {hasDot ? TokenType::FLOAT : TokenType::INT,
+              {start, size_t(mark() - start)},
+              line};
     }
 
-    case State::STRING:
-      while (!endOfFile && currentChar != '"') {
-        if (currentChar == '\\') {
+    case State::STRING: {
+      start = mark();
+      std::string *unescaped = nullptr;
+      while (!endOfFile) {
+        const char *run = mark();
+        const char *stop = scanString(run, end);
+        if (unescaped)
+          unescaped->append(run, stop - run);
+        skipTo(stop);
+        if (endOfFile || currentChar == '"')
+          break;
+
+        if (currentChar == '\n') {
+          ++line;
+          if (unescaped)
+            *unescaped += '\n';
           advance();
-          switch (currentChar) {
-          case 'n':
-            currentChar = '\n';
-            break;
-          case 't':
-            currentChar = '\t';
-            break;
-          case '\\':
-            currentChar = '\\';
-            break;
-          case '"':
-            currentChar = '\"';
-            break;
-          case '\'':
-            currentChar = '\'';
-            break;
-          default:
-            break;
-          }
+          continue;
         }
-        lexeme += currentChar;
+
+        if (!unescaped) {
+          unescaped = &ownedLexemes.emplace_back(start, mark() - start);
+        }
+        advance();
+        if (endOfFile)
+          break;
+        switch (currentChar) {
+        case 'n':
+          currentChar = '\n';
+          break;
+        case 't':
+          currentChar = '\t';
+          break;
+        case '\\':
+          currentChar = '\\';
+          break;
+        case '"':
+          currentChar = '\"';
+          break;
+        case '\'':
+          currentChar = '\'';
+          break;
+        case '\n':
+          ++line;
+          break;
+        default:
+          break;
+        }
+        *unescaped += currentChar;
         advance();
       }
+      std::string_view lexeme =
+          unescaped ? std::string_view(*unescaped)
+                    : std::string_view(start, mark() - start);
       if (currentChar == '"') {
         advance();
         return {TokenType::STRING, lexeme, line};
       } else {
         return {TokenType::UNKNOWN, lexeme, line};
       }
+    }
 
     case State::ERROR:
+      start = mark();
       while (!std::isspace(currentChar) && !endOfFile) {
-        lexeme += currentChar;
         advance();
       }
-      return {TokenType::UNKNOWN, lexeme, line};
+      return {TokenType::UNKNOWN, {start, size_t(mark() - start)}, line};
     }
   }
 
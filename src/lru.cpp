@@ -0,0 +1,29 @@
+#include <algorithm>
+#include <filesystem>
+#include <lru.hpp>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+void markUsed(const std::string &path) {
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+void evictLeastRecentlyUsed(const std::string &dir, size_t keep) {
+  std::error_code ec;
+  std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    if (entry.path().filename().string().find(".tmp") != std::string::npos)
+      continue;
+    auto time = entry.last_write_time(ec);
+    if (!ec)
+      entries.emplace_back(time, entry.path());
+  }
+  if (entries.size() <= keep)
+    return;
+  std::sort(entries.begin(), entries.end());
+  for (size_t i = 0; i < entries.size() - keep; ++i)
+    fs::remove_all(entries[i].second, ec);
+}
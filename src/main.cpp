@@ -1,12 +1,24 @@
-#include <ast.hpp>
+#include <algorithm>
+#include <build_cache.hpp>
+#include <cfg.hpp>
+#include <chrono>
+#include <codegen.hpp>
+#include <csignal>
 #include <cstdlib>
+#include <engine.hpp>
 #include <filesystem>
+#include <flat_ast.hpp>
+#include <frontend.hpp>
 #include <fstream>
 #include <iostream>
-#include <lexer.hpp>
-#include <parser.hpp>
+#include <prune.hpp>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <trace.hpp>
 #include <unistd.h>
+#include <vector>
+#include <watch.hpp>
 
 std::string getExecutablePath() {
   char result[1024];
@@ -19,16 +31,218 @@ std::string getExecutablePath() {
 
 void printHelp() {
   std::cout << "Uso: compiler <archivo_entrada.sst> [opciones]\n"
+            << "  Use '-' como archivo de entrada para leer desde stdin.\n"
             << "\n"
             << "Opciones:\n"
             << "  -o <archivo_salida>   Especifica el nombre del ejecutable de "
                "salida (por defecto: 'juego').\n"
+            << "  -j <n>                Número de hilos para analizar el "
+               "guion (por defecto: núcleos disponibles).\n"
+            << "  --embed               Integra la historia en el ejecutable "
+               "en lugar de leer story.bin.\n"
+            << "  --json                Escribe también la historia en "
+               "JSON (.tmp/story.json) para depurar.\n"
+            << "  --watch               Tras compilar, vuelve a generar la "
+               "historia cada vez que se guarda el guion.\n"
+            << "  --trace=<archivo>     Guarda la duración de cada fase en "
+               "formato Chrome trace.\n"
             << "  -h, --help              Muestra este mensaje de ayuda.\n";
 }
 
-int main(int argc, char *argv[]) {
+struct Options {
   std::string inputFile;
   std::string outputFile = "juego";
+  std::string traceFile;
+  bool writeJson = false;
+  bool embedStory = false;
+  bool watch = false;
+  unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+};
+
+// Parses with incremental when given, so that --watch can reuse the labels
+// that an edit did not touch.
+std::unique_ptr<ProgramNode> parse(const Options &options,
+                                   const std::string &compilerPath,
+                                   IncrementalParser *incremental) {
+  std::unique_ptr<ProgramNode> tree;
+  {
+    TraceSpan span("parse script");
+    if (incremental)
+      tree = incremental->parse(options.inputFile.c_str());
+    else
+      tree = parseScript(options.inputFile.c_str(), compilerPath,
+                         options.jobs);
+  }
+  for (const auto &arena : tree->arenas)
+    traceCount("nodes", arena->objectCount());
+  return tree;
+}
+
+std::string storyPath(const Options &options, const std::string &tmpPath) {
+  return tmpPath + (options.embedStory ? "/historia.cpp" : "/story.bin");
+}
+
+// Writes the story as story.bin, or as historia.cpp with --embed, and as
+// story.json with --json. story.bin is replaced by renaming a new copy over
+// it, so a running game that has it mapped never sees a partial file.
+// Returns the warnings found, one per line.
+std::string writeStory(const ProgramNode &tree, const Options &options,
+                       const std::string &tmpPath) {
+  FlatProgram program;
+  {
+    TraceSpan span("flatten");
+    program = flatten(tree);
+  }
+
+  std::string warnings;
+  {
+    TraceSpan span("prune");
+    for (Symbol label : removeUnreachableLabels(program)) {
+      warnings += "Advertencia: La etiqueta '" + std::string(nameOf(label)) +
+                  "' no es alcanzable desde 'start' y se omitirá.\n";
+    }
+    pruneUnusedAssets(program);
+  }
+
+  {
+    TraceSpan span("generate story");
+    std::string path = storyPath(options, tmpPath);
+    std::string tmp = path + ".tmp";
+    {
+      std::ofstream output(tmp, std::ios::binary);
+      if (!output.is_open()) {
+        throw std::runtime_error("No se pudo abrir " + tmp);
+      }
+
+      if (options.embedStory) {
+        std::ostringstream bytecode;
+        generateBytecode(program, bytecode);
+        generateStorySource(bytecode.str(), output);
+      } else {
+        generateBytecode(program, output);
+      }
+      traceCount("bytes written", output.tellp());
+    }
+    std::filesystem::rename(tmp, path);
+  }
+
+  if (options.writeJson) {
+    TraceSpan span("generate story json");
+    std::string jsonPath = tmpPath + "/story.json";
+    std::ofstream output(jsonPath);
+    if (!output.is_open()) {
+      throw std::runtime_error("No se pudo abrir " + jsonPath);
+    }
+
+    generateStory(program, output);
+    traceCount("bytes written", output.tellp());
+  }
+  return warnings;
+}
+
+// Compiles the script into the game, or restores the same build from the
+// cache. Returns the files the script was parsed from.
+std::vector<std::string> build(const Options &options,
+                               const std::string &compilerPath,
+                               IncrementalParser *incremental) {
+  std::string tmpPath = compilerPath + "/.tmp";
+  std::unique_ptr<ProgramNode> tree = parse(options, compilerPath, incremental);
+
+  // Asset paths are made absolute, so the working directory is part of
+  // the output.
+  std::string key = std::filesystem::current_path().string() +
+                    (options.embedStory ? "\nembed" : "\nplayer") +
+                    (options.writeJson ? "\njson" : "");
+  std::vector<BuildArtifact> artifacts{{"juego", options.outputFile, ""}};
+  if (!options.embedStory)
+    artifacts.push_back({"story.bin", storyPath(options, tmpPath), ""});
+  if (options.writeJson)
+    artifacts.push_back({"story.json", tmpPath + "/story.json", ""});
+
+  uint64_t hash;
+  {
+    TraceSpan span("hash build");
+    hash = buildKey(tree->sourceHash, compilerPath, key);
+  }
+  BuildCache cache(compilerPath, hash);
+  std::string warnings;
+  if (cache.restore(artifacts, warnings)) {
+    traceCount("cached builds", 1);
+    std::cerr << warnings;
+    return tree->sources;
+  }
+
+  warnings = writeStory(*tree, options, tmpPath);
+  std::cerr << warnings;
+
+  {
+    TraceSpan span("build engine");
+    if (options.embedStory) {
+      linkEmbeddedGame(compilerPath, storyPath(options, tmpPath),
+                       options.outputFile);
+    } else {
+      // Every player build is the same engine, so cache entries link to it.
+      artifacts[0].shared = buildEngine(compilerPath);
+      std::filesystem::copy_file(
+          artifacts[0].shared, options.outputFile,
+          std::filesystem::copy_options::overwrite_existing);
+    }
+  }
+
+  TraceSpan span("store build");
+  cache.store(artifacts, warnings);
+  return tree->sources;
+}
+
+volatile std::sig_atomic_t stopWatching = 0;
+
+void onInterrupt(int) { stopWatching = 1; }
+
+// Rebuilds the story every time one of its files is saved, until Ctrl+C.
+// The engine does not change, so only the story is written again; a running
+// game notices the new story.bin and reloads it. With --embed the game is
+// linked again instead. Only the labels an edit touched are parsed again, and
+// the module cache does the same for imported files.
+void watch(const Options &options, const std::string &compilerPath,
+           IncrementalParser &incremental, std::vector<std::string> sources) {
+  // Without SA_RESTART the signal interrupts the watcher's read().
+  struct sigaction action = {};
+  action.sa_handler = onInterrupt;
+  sigaction(SIGINT, &action, nullptr);
+
+  std::string tmpPath = compilerPath + "/.tmp";
+  FileWatcher watcher;
+  std::cout << "Esperando cambios en el guion (Ctrl+C para salir)..."
+            << std::endl;
+  while (!stopWatching) {
+    watcher.watch(sources);
+    if (!watcher.wait())
+      break;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+      TraceSpan span("update story");
+      std::unique_ptr<ProgramNode> tree =
+          parse(options, compilerPath, &incremental);
+      std::cerr << writeStory(*tree, options, tmpPath);
+      if (options.embedStory) {
+        linkEmbeddedGame(compilerPath, storyPath(options, tmpPath),
+                         options.outputFile);
+      }
+      sources = tree->sources;
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      continue;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "Historia actualizada en " << elapsed.count() << " ms."
+              << std::endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
 
   if (argc < 2) {
     printHelp();
@@ -44,15 +258,37 @@ int main(int argc, char *argv[]) {
 
     } else if (arg == "-o") {
       if (i + 1 < argc) {
-        outputFile = argv[++i];
+        options.outputFile = argv[++i];
 
       } else {
         std::cerr << "Error: La opción '-o' requiere un argumento."
                   << std::endl;
         return 1;
       }
-    } else if (inputFile.empty()) {
-      inputFile = arg;
+    } else if (arg == "-j") {
+      if (i + 1 < argc) {
+        options.jobs = std::max(1, std::atoi(argv[++i]));
+
+      } else {
+        std::cerr << "Error: La opción '-j' requiere un argumento."
+                  << std::endl;
+        return 1;
+      }
+    } else if (arg == "--json") {
+      options.writeJson = true;
+    } else if (arg == "--embed") {
+      options.embedStory = true;
+    } else if (arg == "--watch") {
+      options.watch = true;
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      options.traceFile = arg.substr(8);
+      if (options.traceFile.empty()) {
+        std::cerr << "Error: La opción '--trace' requiere un archivo."
+                  << std::endl;
+        return 1;
+      }
+    } else if (options.inputFile.empty()) {
+      options.inputFile = arg;
     } else {
       std::cerr << "Error: Se especificó un archivo de entrada más de una vez."
                 << std::endl;
@@ -60,50 +296,49 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  if (inputFile.empty()) {
+  if (options.inputFile.empty()) {
     std::cerr << "Error: No se especificó ningún archivo de entrada."
               << std::endl;
     return 1;
   }
+  if (options.watch && options.inputFile == "-") {
+    std::cerr << "Error: La opción '--watch' no se puede usar al leer desde "
+                 "stdin."
+              << std::endl;
+    return 1;
+  }
+
+  Tracer &tracer = Tracer::getInstance();
+  if (!options.traceFile.empty())
+    tracer.start(options.traceFile);
 
+  int status = 0;
   try {
     std::string compilerPath = getExecutablePath();
-    std::string tmpPath = compilerPath + "/.tmp";
-    std::string resPath = compilerPath + "/../res";
-
-    system(("mkdir -p " + tmpPath).c_str());
-
-    system(("cp " + resPath + "/nlohmann_json.hpp " + tmpPath + "/").c_str());
-
-    Lexer lexer(inputFile.c_str());
-    Parser parser(lexer, compilerPath);
-    auto ast = parser.parseProgram();
-
-    std::string jsonPath = tmpPath + "/story.json";
-    std::ofstream output(jsonPath);
-    if (!output.is_open()) {
-      throw std::runtime_error("No se pudo abrir " + jsonPath);
+    IncrementalParser incremental(compilerPath, options.jobs);
+    std::vector<std::string> sources;
+    {
+      TraceSpan total("compiler");
+      std::filesystem::create_directories(compilerPath + "/.tmp");
+      sources = build(options, compilerPath,
+                      options.watch ? &incremental : nullptr);
     }
 
-    ast->generateCode(output, 0);
-    output.close();
-
-    std::string compileCommand = "g++ -std=c++17 -o " + outputFile + " " +
-                                 tmpPath + "/juego_generado.cpp -I" + tmpPath +
-                                 " -lsfml-graphics -lsfml-window "
-                                 "-lsfml-system -lsfml-audio";
-
-    int compileResult = system(compileCommand.c_str());
-    if (compileResult != 0) {
-      throw std::runtime_error("Falló la compilación del juego.");
-    }
-
-    std::cout << "Compilación exitosa. Ejecute: ./" << outputFile << std::endl;
+    std::cout << "Compilación exitosa. Ejecute: ./" << options.outputFile
+              << std::endl;
+    if (options.watch)
+      watch(options, compilerPath, incremental, sources);
 
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << std::endl;
-    return 1;
+    status = 1;
   }
 
-  return 0;
+  try {
+    tracer.finish();
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    status = 1;
+  }
+  return status;
 }
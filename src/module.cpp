@@ -0,0 +1,698 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <hash.hpp>
+#include <lexer.hpp>
+#include <lru.hpp>
+#include <module.hpp>
+#include <parser.hpp>
+#include <source.hpp>
+#include <stdexcept>
+#include <thread>
+#include <trace.hpp>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC = 0x4d545353; // "SSTM"
+constexpr uint32_t CACHE_VERSION = 4;
+// Entries kept in the module cache, unless one compile uses more.
+constexpr size_t MAX_CACHED_MODULES = 256;
+
+struct Module {
+  std::string path;
+  std::unique_ptr<Arena> arena;
+  NodeList statements;
+  std::vector<SymbolRef> unresolved;
+  // Module index of each top-level import, in statement order.
+  std::vector<size_t> imports;
+  // Hash of the module's contents.
+  uint64_t hash = 0;
+  std::exception_ptr error;
+
+  explicit Module(std::string path) : path(std::move(path)) {}
+};
+
+class CacheWriter {
+  std::string data;
+
+public:
+  const std::string &bytes() const { return data; }
+
+  void u8(uint8_t v) { data += static_cast<char>(v); }
+  void u32(uint32_t v) { data.append(reinterpret_cast<const char *>(&v), 4); }
+  void u64(uint64_t v) { data.append(reinterpret_cast<const char *>(&v), 8); }
+  void f64(double v) { data.append(reinterpret_cast<const char *>(&v), 8); }
+  void str(std::string_view s) {
+    u32(s.size());
+    data.append(s);
+  }
+  void sym(Symbol s) { str(nameOf(s)); }
+
+  void params(const Parameters &parameters) {
+    u8(parameters.present);
+    for (size_t i = 0; i < static_cast<size_t>(Param::COUNT); ++i) {
+      if (parameters.has(static_cast<Param>(i)))
+        f64(parameters.values[i]);
+    }
+  }
+
+  void statements(const NodeList &nodes) {
+    u32(nodes.size());
+    for (const auto &node : nodes)
+      this->node(*node);
+  }
+
+  void node(const ASTNode &node) {
+    u8(static_cast<uint8_t>(node.kind));
+    switch (node.kind) {
+    case NodeKind::BACKGROUND: {
+      auto &n = static_cast<const BackgroundNode &>(node);
+      sym(n.name);
+      str(n.imagePath);
+      params(n.parameters);
+      break;
+    }
+    case NodeKind::CHARACTER: {
+      auto &n = static_cast<const CharacterNode &>(node);
+      sym(n.id);
+      str(n.displayName);
+      u32(n.modes.size());
+      for (const auto &mode : n.modes) {
+        sym(mode->name);
+        str(mode->imagePath);
+        params(mode->parameters);
+      }
+      break;
+    }
+    case NodeKind::SCENE: {
+      auto &n = static_cast<const SceneNode &>(node);
+      sym(n.name);
+      params(n.parameters);
+      break;
+    }
+    case NodeKind::SHOW: {
+      auto &n = static_cast<const ShowNode &>(node);
+      sym(n.characterId);
+      sym(n.mode);
+      params(n.parameters);
+      break;
+    }
+    case NodeKind::HIDE: {
+      auto &n = static_cast<const HideNode &>(node);
+      sym(n.characterId);
+      params(n.parameters);
+      break;
+    }
+    case NodeKind::DIALOGUE: {
+      auto &n = static_cast<const DialogueNode &>(node);
+      sym(n.speaker);
+      str(n.text);
+      params(n.parameters);
+      break;
+    }
+    case NodeKind::MUSIC: {
+      auto &n = static_cast<const MusicNode &>(node);
+      sym(n.id);
+      str(n.filePath);
+      break;
+    }
+    case NodeKind::PLAY:
+      sym(static_cast<const PlayNode &>(node).musicId);
+      break;
+    case NodeKind::STOP:
+      sym(static_cast<const StopNode &>(node).musicId);
+      break;
+    case NodeKind::CHOICE: {
+      auto &n = static_cast<const ChoiceNode &>(node);
+      str(n.prompt);
+      u32(n.options.size());
+      for (const auto &option : n.options) {
+        str(option->text);
+        sym(option->gotoLabel);
+      }
+      break;
+    }
+    case NodeKind::LABEL: {
+      auto &n = static_cast<const LabelNode &>(node);
+      sym(n.name);
+      statements(n.statements);
+      break;
+    }
+    case NodeKind::JUMP:
+      sym(static_cast<const JumpNode &>(node).target);
+      break;
+    case NodeKind::IMPORT:
+      str(static_cast<const ImportNode &>(node).path);
+      break;
+    case NodeKind::END:
+    case NodeKind::PROGRAM:
+    case NodeKind::OPTION:
+      break;
+    }
+  }
+};
+
+// Reads what CacheWriter wrote. Any inconsistency throws, and the caller
+// treats the entry as missing.
+class CacheReader {
+  Arena &arena;
+  const char *p;
+  const char *end;
+
+  void need(size_t n) {
+    if (static_cast<size_t>(end - p) < n)
+      throw std::runtime_error("módulo en caché truncado");
+  }
+  template <typename T> T raw() {
+    need(sizeof(T));
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+  }
+
+public:
+  CacheReader(Arena &arena, std::string_view data)
+      : arena(arena), p(data.data()), end(data.data() + data.size()) {}
+
+  bool done() const { return p == end; }
+
+  // Reads an element count. Every element takes at least a byte, so a count
+  // larger than what is left is rejected before anything is allocated for it.
+  uint32_t count() {
+    uint32_t n = u32();
+    need(n);
+    return n;
+  }
+
+  uint8_t u8() { return raw<uint8_t>(); }
+  uint32_t u32() { return raw<uint32_t>(); }
+  uint64_t u64() { return raw<uint64_t>(); }
+  double f64() { return raw<double>(); }
+  std::string_view view() {
+    uint32_t size = u32();
+    need(size);
+    std::string_view s(p, size);
+    p += size;
+    return s;
+  }
+  std::string str() { return std::string(view()); }
+  Symbol sym() { return intern(view()); }
+
+  void str(std::pmr::string &s) { s = view(); }
+
+  void params(Parameters &parameters) {
+    uint8_t present = u8();
+    for (size_t i = 0; i < static_cast<size_t>(Param::COUNT); ++i) {
+      if (present & (1u << i))
+        parameters.set(static_cast<Param>(i), f64());
+    }
+    if (parameters.present != present)
+      throw std::runtime_error("parámetro inválido en caché");
+  }
+
+  void statements(NodeList &nodes) {
+    uint32_t n = count();
+    nodes.reserve(n);
+    for (uint32_t i = 0; i < n; ++i)
+      nodes.push_back(node());
+  }
+
+  ASTNode *node() {
+    switch (static_cast<NodeKind>(u8())) {
+    case NodeKind::BACKGROUND: {
+      auto n = arena.make<BackgroundNode>();
+      n->name = sym();
+      str(n->imagePath);
+      params(n->parameters);
+      return n;
+    }
+    case NodeKind::CHARACTER: {
+      auto n = arena.make<CharacterNode>();
+      n->id = sym();
+      str(n->displayName);
+      uint32_t modes = count();
+      for (uint32_t i = 0; i < modes; ++i) {
+        auto mode = arena.make<CharacterModeData>();
+        mode->name = sym();
+        str(mode->imagePath);
+        params(mode->parameters);
+        n->modes.push_back(mode);
+      }
+      return n;
+    }
+    case NodeKind::SCENE: {
+      auto n = arena.make<SceneNode>();
+      n->name = sym();
+      params(n->parameters);
+      return n;
+    }
+    case NodeKind::SHOW: {
+      auto n = arena.make<ShowNode>();
+      n->characterId = sym();
+      n->mode = sym();
+      params(n->parameters);
+      return n;
+    }
+    case NodeKind::HIDE: {
+      auto n = arena.make<HideNode>();
+      n->characterId = sym();
+      params(n->parameters);
+      return n;
+    }
+    case NodeKind::DIALOGUE: {
+      auto n = arena.make<DialogueNode>();
+      n->speaker = sym();
+      str(n->text);
+      params(n->parameters);
+      return n;
+    }
+    case NodeKind::MUSIC: {
+      auto n = arena.make<MusicNode>();
+      n->id = sym();
+      str(n->filePath);
+      return n;
+    }
+    case NodeKind::PLAY: {
+      auto n = arena.make<PlayNode>();
+      n->musicId = sym();
+      return n;
+    }
+    case NodeKind::STOP: {
+      auto n = arena.make<StopNode>();
+      n->musicId = sym();
+      return n;
+    }
+    case NodeKind::CHOICE: {
+      auto n = arena.make<ChoiceNode>();
+      str(n->prompt);
+      uint32_t options = count();
+      for (uint32_t i = 0; i < options; ++i) {
+        auto option = arena.make<OptionNode>();
+        str(option->text);
+        option->gotoLabel = sym();
+        n->options.push_back(option);
+      }
+      return n;
+    }
+    case NodeKind::LABEL: {
+      auto n = arena.make<LabelNode>();
+      n->name = sym();
+      statements(n->statements);
+      return n;
+    }
+    case NodeKind::JUMP: {
+      auto n = arena.make<JumpNode>();
+      n->target = sym();
+      return n;
+    }
+    case NodeKind::END:
+      return arena.make<EndNode>();
+    case NodeKind::IMPORT: {
+      auto n = arena.make<ImportNode>();
+      str(n->path);
+      return n;
+    }
+    default:
+      break;
+    }
+    throw std::runtime_error("nodo inválido en caché");
+  }
+};
+
+std::string cacheFile(const std::string &cacheDir, uint64_t hash) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.sstm",
+                static_cast<unsigned long long>(hash));
+  return cacheDir + "/" + name;
+}
+
+bool loadCached(const std::string &file, uint64_t hash, size_t size,
+                Module &module) {
+  if (access(file.c_str(), R_OK) != 0)
+    return false;
+  try {
+    SourceFile cached(file.c_str());
+    module.arena = std::make_unique<Arena>();
+    CacheReader in(*module.arena, cached.text());
+    if (in.u32() != CACHE_MAGIC || in.u32() != CACHE_VERSION ||
+        in.u64() != hash || in.u64() != size)
+      return false;
+    uint32_t refs = in.count();
+    for (uint32_t i = 0; i < refs; ++i) {
+      SymbolRef ref;
+      uint8_t kind = in.u8();
+      if (kind > static_cast<uint8_t>(RefKind::MUSIC))
+        throw std::runtime_error("referencia inválida en caché");
+      ref.kind = static_cast<RefKind>(kind);
+      ref.name = in.sym();
+      ref.mode = in.sym();
+      ref.line = static_cast<int>(in.u32());
+      module.unresolved.push_back(ref);
+    }
+    in.statements(module.statements);
+    if (!in.done())
+      throw std::runtime_error("módulo en caché con datos de más");
+  } catch (const std::exception &) {
+    module.statements.clear();
+    module.unresolved.clear();
+    module.arena.reset();
+    return false;
+  }
+  markUsed(file);
+  return true;
+}
+
+// Best effort: a module that cannot be cached is simply parsed again next
+// time. The entry is written under a temporary name and renamed into place
+// so concurrent compilations never read half a file.
+void storeCached(const std::string &file, uint64_t hash, size_t size,
+                 const Module &module) {
+  CacheWriter out;
+  out.u32(CACHE_MAGIC);
+  out.u32(CACHE_VERSION);
+  out.u64(hash);
+  out.u64(size);
+  out.u32(module.unresolved.size());
+  for (const SymbolRef &ref : module.unresolved) {
+    out.u8(static_cast<uint8_t>(ref.kind));
+    out.sym(ref.name);
+    out.sym(ref.mode);
+    out.u32(ref.line);
+  }
+  out.statements(module.statements);
+
+  std::string tmp =
+      file + ".tmp" + std::to_string(getpid()) + "." +
+      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  bool written;
+  {
+    std::ofstream stream(tmp, std::ios::binary);
+    written = static_cast<bool>(
+        stream.write(out.bytes().data(), out.bytes().size()));
+  }
+  std::error_code ec;
+  if (written)
+    fs::rename(tmp, file, ec);
+  if (!written || ec)
+    fs::remove(tmp, ec);
+}
+
+void loadModule(Module &module, std::string_view text,
+                const std::string &compilerPath, const std::string &cacheDir) {
+  TraceSpan span("load module", module.path);
+  module.hash = fnv1a(text);
+  // The entry depends on how this compiler parses, not just on the text.
+  uint64_t hash = fnv1a(text, compilerHash());
+  std::string file = cacheFile(cacheDir, hash);
+  if (loadCached(file, hash, text.size(), module)) {
+    traceCount("cached modules", 1);
+    return;
+  }
+
+  try {
+    Lexer lexer(text);
+    Parser parser(lexer, compilerPath);
+    parser.deferUndefinedReferences();
+    parser.parseStatements(module.statements);
+    traceCount("tokens", lexer.tokenCount());
+    module.unresolved = std::move(parser.symbolTable().unresolved);
+    module.arena = parser.releaseArena();
+  } catch (const std::exception &e) {
+    throw std::runtime_error(module.path + ": " + e.what());
+  }
+  storeCached(file, hash, text.size(), module);
+}
+
+std::string moduleKey(const std::string &path) {
+  if (path == "-")
+    return path;
+  std::error_code ec;
+  fs::path canonical = fs::weakly_canonical(path, ec);
+  return ec ? path : canonical.string();
+}
+
+// Appends module `index` to order and then, depth first, every module it
+// imports for the first time.
+void importOrder(const std::vector<std::unique_ptr<Module>> &modules,
+                 size_t index, std::vector<bool> &seen,
+                 std::vector<size_t> &order) {
+  seen[index] = true;
+  order.push_back(index);
+  for (size_t imported : modules[index]->imports) {
+    if (!seen[imported])
+      importOrder(modules, imported, seen, order);
+  }
+}
+
+void splice(std::vector<std::unique_ptr<Module>> &modules, size_t index,
+            std::vector<bool> &spliced, NodeList &out) {
+  spliced[index] = true;
+  Module &module = *modules[index];
+  size_t next = 0;
+  for (ASTNode *stmt : module.statements) {
+    if (stmt->kind == NodeKind::IMPORT) {
+      size_t imported = module.imports[next++];
+      if (!spliced[imported])
+        splice(modules, imported, spliced, out);
+    } else {
+      out.push_back(stmt);
+    }
+  }
+}
+
+const Module *definedIn(const std::vector<std::unique_ptr<Module>> &modules,
+                        const std::function<bool(const ASTNode &)> &defines) {
+  for (const auto &module : modules) {
+    for (const auto &stmt : module->statements) {
+      if (defines(*stmt))
+        return module.get();
+    }
+  }
+  return nullptr;
+}
+
+class Linker {
+  const std::vector<std::unique_ptr<Module>> &modules;
+  const Module *current = nullptr;
+
+  [[noreturn]] void duplicate(const std::string &what, Symbol name,
+                              const std::function<bool(const ASTNode &)> &is) {
+    const Module *owner = definedIn(modules, is);
+    throw std::runtime_error(current->path + ": Error Semántico: " + what +
+                             " '" + std::string(nameOf(name)) +
+                             "' ya fue definido en " +
+                             (owner ? owner->path : "otro módulo") + ".");
+  }
+
+  void collect(const ASTNode &node) {
+    switch (node.kind) {
+    case NodeKind::BACKGROUND: {
+      auto n = static_cast<const BackgroundNode *>(&node);
+      if (symbols.backgrounds.count(n->name)) {
+        duplicate("El fondo", n->name, [&](const ASTNode &other) {
+          auto b = nodeAs<BackgroundNode>(other);
+          return b && b != n && b->name == n->name;
+        });
+      }
+      symbols.backgrounds.insert(n->name);
+      break;
+    }
+    case NodeKind::CHARACTER: {
+      auto n = static_cast<const CharacterNode *>(&node);
+      if (symbols.characters.count(n->id)) {
+        duplicate("El personaje", n->id, [&](const ASTNode &other) {
+          auto c = nodeAs<CharacterNode>(other);
+          return c && c != n && c->id == n->id;
+        });
+      }
+      SymbolSet &modes = symbols.characters[n->id];
+      for (const auto &mode : n->modes)
+        modes.insert(mode->name);
+      break;
+    }
+    case NodeKind::MUSIC: {
+      auto n = static_cast<const MusicNode *>(&node);
+      if (symbols.music.count(n->id)) {
+        duplicate("La pista de música", n->id, [&](const ASTNode &other) {
+          auto m = nodeAs<MusicNode>(other);
+          return m && m != n && m->id == n->id;
+        });
+      }
+      symbols.music.insert(n->id);
+      break;
+    }
+    case NodeKind::LABEL: {
+      auto &n = static_cast<const LabelNode &>(node);
+      symbols.labels.insert(n.name);
+      for (const auto &stmt : n.statements)
+        collect(*stmt);
+      break;
+    }
+    case NodeKind::JUMP:
+      symbols.jumpTargets.push_back(static_cast<const JumpNode &>(node).target);
+      break;
+    case NodeKind::CHOICE:
+      for (const auto &option : static_cast<const ChoiceNode &>(node).options)
+        symbols.jumpTargets.push_back(option->gotoLabel);
+      break;
+    default:
+      break;
+    }
+  }
+
+  [[noreturn]] void undefined(const SymbolRef &ref, const std::string &what) {
+    throw std::runtime_error(current->path + ": [Línea " +
+                             std::to_string(ref.line) +
+                             "] Error Semántico: " + what);
+  }
+
+  void resolve(const SymbolRef &ref) {
+    std::string name = "'" + std::string(nameOf(ref.name)) + "'";
+    switch (ref.kind) {
+    case RefKind::BACKGROUND:
+      if (!symbols.backgrounds.count(ref.name))
+        undefined(ref, "El fondo " + name + " no ha sido definido.");
+      break;
+    case RefKind::CHARACTER:
+    case RefKind::MODE:
+      if (!symbols.characters.count(ref.name))
+        undefined(ref, "El personaje " + name + " no ha sido definido.");
+      if (ref.kind == RefKind::MODE &&
+          !symbols.characters.at(ref.name).count(ref.mode)) {
+        undefined(ref, "El modo '" + std::string(nameOf(ref.mode)) +
+                           "' no está definido para el personaje " + name +
+                           ".");
+      }
+      break;
+    case RefKind::MUSIC:
+      if (!symbols.music.count(ref.name))
+        undefined(ref,
+                  "La pista de música " + name + " no ha sido definida.");
+      break;
+    }
+  }
+
+public:
+  SymbolTable symbols;
+
+  explicit Linker(const std::vector<std::unique_ptr<Module>> &modules)
+      : modules(modules) {}
+
+  void link(const std::vector<size_t> &order) {
+    for (size_t index : order) {
+      current = modules[index].get();
+      for (const auto &stmt : current->statements)
+        collect(*stmt);
+    }
+    for (size_t index : order) {
+      current = modules[index].get();
+      for (const SymbolRef &ref : current->unresolved)
+        resolve(ref);
+    }
+    checkJumpTargets(symbols);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<ProgramNode>
+parseModules(const char *path, std::string_view text,
+             const std::string &compilerPath, unsigned jobs,
+             SourceFile::Mode mode) {
+  std::string cacheDir = compilerPath + "/.tmp/modules";
+  std::error_code ec;
+  fs::create_directories(cacheDir, ec);
+
+  std::vector<std::unique_ptr<Module>> modules;
+  std::unordered_map<std::string, size_t> byKey;
+  modules.push_back(std::make_unique<Module>(path));
+  byKey.emplace(moduleKey(path), 0);
+  loadModule(*modules[0], text, compilerPath, cacheDir);
+
+  // Each wave loads the modules first imported by the previous one.
+  size_t waveStart = 0;
+  size_t waveEnd = 1;
+  while (waveStart < waveEnd) {
+    for (size_t i = waveStart; i < waveEnd; ++i) {
+      Module &module = *modules[i];
+      fs::path dir = module.path == "-"
+                         ? fs::path()
+                         : fs::path(module.path).parent_path();
+      for (const auto &stmt : module.statements) {
+        auto import = nodeAs<ImportNode>(*stmt);
+        if (!import)
+          continue;
+        std::string importPath = (dir / import->path).lexically_normal();
+        auto [it, added] = byKey.emplace(moduleKey(importPath), modules.size());
+        if (added)
+          modules.push_back(std::make_unique<Module>(importPath));
+        module.imports.push_back(it->second);
+      }
+    }
+    waveStart = waveEnd;
+    waveEnd = modules.size();
+
+    std::atomic<size_t> next{waveStart};
+    auto worker = [&] {
+      for (size_t i = next++; i < waveEnd; i = next++) {
+        Module &module = *modules[i];
+        try {
+          SourceFile source(module.path.c_str(), mode);
+          loadModule(module, source.text(), compilerPath, cacheDir);
+        } catch (...) {
+          module.error = std::current_exception();
+        }
+      }
+    };
+    std::vector<std::thread> workers;
+    size_t threads = std::min<size_t>(jobs, waveEnd - waveStart);
+    for (size_t t = 1; t < threads; ++t)
+      workers.emplace_back(worker);
+    worker();
+    for (auto &thread : workers)
+      thread.join();
+
+    for (size_t i = waveStart; i < waveEnd; ++i) {
+      if (modules[i]->error)
+        std::rethrow_exception(modules[i]->error);
+    }
+  }
+
+  // Every module of this compile was just stored or marked used, so none of
+  // them is among the entries evicted.
+  evictLeastRecentlyUsed(cacheDir,
+                         std::max(MAX_CACHED_MODULES, modules.size()));
+
+  std::vector<bool> seen(modules.size());
+  std::vector<size_t> order;
+  importOrder(modules, 0, seen, order);
+  TraceSpan span("link modules");
+  Linker linker(modules);
+  linker.link(order);
+
+  auto program = std::make_unique<ProgramNode>(compilerPath);
+  std::vector<bool> spliced(modules.size());
+  splice(modules, 0, spliced, program->statements);
+  program->sourceHash = FNV_OFFSET;
+  for (auto &module : modules) {
+    program->arenas.push_back(std::move(module->arena));
+    program->sourceHash = fnv1a(
+        std::string_view(reinterpret_cast<const char *>(&module->hash),
+                         sizeof(module->hash)),
+        program->sourceHash);
+    if (module->path != "-")
+      program->sources.push_back(module->path);
+  }
+  return program;
+}
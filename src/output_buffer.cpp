@@ -0,0 +1,71 @@
+#include <charconv>
+#include <cstdio>
+#include <output_buffer.hpp>
+
+void OutputBuffer::flush() {
+  if (used)
+    out.write(buffer.get(), used);
+  used = 0;
+}
+
+OutputBuffer &OutputBuffer::operator<<(uint32_t value) {
+  reserve(10);
+  char *start = buffer.get() + used;
+  used += std::to_chars(start, start + 10, value).ptr - start;
+  return *this;
+}
+
+OutputBuffer &OutputBuffer::operator<<(double value) {
+  char text[32];
+  int n = std::snprintf(text, sizeof(text), "%g", value);
+  return *this << std::string_view(text, n);
+}
+
+namespace {
+
+// Escape sequence for c, or null when c is written as is.
+constexpr const char *escapeFor(char c) {
+  switch (c) {
+  case '"':
+    return "\\\"";
+  case '\\':
+    return "\\\\";
+  case '\b':
+    return "\\b";
+  case '\f':
+    return "\\f";
+  case '\n':
+    return "\\n";
+  case '\r':
+    return "\\r";
+  case '\t':
+    return "\\t";
+  default:
+    return nullptr;
+  }
+}
+
+struct EscapeTable {
+  bool needed[256] = {};
+  constexpr EscapeTable() {
+    for (int c = 0; c < 256; ++c)
+      needed[c] = escapeFor(static_cast<char>(c)) != nullptr;
+  }
+};
+
+constexpr EscapeTable ESCAPES;
+
+} // namespace
+
+OutputBuffer &OutputBuffer::operator<<(Escaped escaped) {
+  std::string_view s = escaped.text;
+  size_t run = 0;
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (!ESCAPES.needed[static_cast<unsigned char>(s[i])])
+      continue;
+    const char *escape = escapeFor(s[i]);
+    *this << s.substr(run, i - run) << std::string_view(escape, 2);
+    run = i + 1;
+  }
+  return *this << s.substr(run);
+}
@@ -1,50 +1,48 @@
+#include <array>
 #include <ast.hpp>
 #include <parser.hpp>
 #include <stdexcept>
 #include <token.hpp>
 #include <unistd.h>
 
-void checkParameterImage(const std::string &name, const std::string &value,
-                         ParameterValue &buffValue) {
-  if (name == "x" || name == "y" || name == "scale") {
-    try {
-      buffValue = std::stod(value);
-    } catch (const std::invalid_argument &e) {
-      throw std::runtime_error(
-          "[Error: Se ingreso un valor incorrecto para el parametro: " + name +
-          "]");
-    } catch (const std::out_of_range &e) {
-      throw std::runtime_error(
-          "[Error: El valor es muy grande para el parametro : " + name + "]");
-    }
-    return;
+double parameterValue(const std::string &name, std::string_view value) {
+  try {
+    return std::stod(std::string(value));
+  } catch (const std::invalid_argument &e) {
+    throw std::runtime_error(
+        "[Error: Se ingreso un valor incorrecto para el parametro: " + name +
+        "]");
+  } catch (const std::out_of_range &e) {
+    throw std::runtime_error(
+        "[Error: El valor es muy grande para el parametro : " + name + "]");
   }
-  throw std::runtime_error("[Error: No existe el parametro : " + name + "]");
 }
 
-void checkParameterDialogue(const std::string &name, const std::string &value,
-                            ParameterValue &buffValue) {
-  if (name == "size" || name == "speed") {
-    try {
-      buffValue = std::stod(value);
-    } catch (const std::invalid_argument &e) {
-      throw std::runtime_error(
-          "[Error: Se ingreso un valor incorrecto para el parametro: " + name +
-          "]");
-    } catch (const std::out_of_range &e) {
-      throw std::runtime_error(
-          "[Error: El valor es muy grande para el parametro : " + name + "]");
-    }
-    return;
-  }
-  throw std::runtime_error("[Error: No existe el parametro : " + name + "]");
-  return;
+void checkParameterImage(const std::string &name, std::string_view value,
+                         Parameters &parameters) {
+  if (name == "x")
+    parameters.set(Param::X, parameterValue(name, value));
+  else if (name == "y")
+    parameters.set(Param::Y, parameterValue(name, value));
+  else if (name == "scale")
+    parameters.set(Param::SCALE, parameterValue(name, value));
+  else
+    throw std::runtime_error("[Error: No existe el parametro : " + name + "]");
+}
+
+void checkParameterDialogue(const std::string &name, std::string_view value,
+                            Parameters &parameters) {
+  if (name == "size")
+    parameters.set(Param::SIZE, parameterValue(name, value));
+  else if (name == "speed")
+    parameters.set(Param::SPEED, parameterValue(name, value));
+  else
+    throw std::runtime_error("[Error: No existe el parametro : " + name + "]");
 }
 
 std::string tokenToString(TokenType type) {
-  auto it = tokenStr.find(type);
-  if (it != tokenStr.end())
-    return it->second;
+  if (static_cast<size_t>(type) < TOKEN_TYPE_COUNT)
+    return std::string(tokenStr(type));
   return "UNDEFINED";
 }
 
@@ -69,63 +67,103 @@ void Parser::expect(TokenType type, const std::string &msg) {
   advance();
 }
 
-std::unique_ptr<ProgramNode> Parser::parseProgram() {
-  auto program = std::make_unique<ProgramNode>(compilerPath);
-
-  while (current.type != TokenType::END_OF_FILE) {
-    if (isBackground()) {
-      program->statements.push_back(parseBackground());
-    } else if (isDefine()) {
-      program->statements.push_back(parseDefine());
-    } else if (isScene()) {
-      program->statements.push_back(parseScene());
-    } else if (isShow()) {
-      program->statements.push_back(parseShow());
-    } else if (isHide()) {
-      program->statements.push_back(parseHide());
-    } else if (isDialogue()) {
-      program->statements.push_back(parseDialogue());
-    } else if (isMusic()) {
-      program->statements.push_back(parseMusic());
-    } else if (isPlay()) {
-      program->statements.push_back(parsePlay());
-    } else if (isStop()) {
-      program->statements.push_back(parseStop());
-    } else if (isChoice()) {
-      program->statements.push_back(parseChoice());
-    } else if (isLabel()) {
-      program->statements.push_back(parseLabel());
-    } else if (isJump()) {
-      program->statements.push_back(parseJump());
-    } else if (isEnd()) {
-      program->statements.push_back(parseEnd());
-    } else {
-      throw std::runtime_error("[Línea " + std::to_string(current.line) +
-                               "] Sentencia inválida");
-    }
-  }
-
-  for (const auto &target : symbols.jumpTargets) {
+void checkJumpTargets(const SymbolTable &symbols) {
+  for (Symbol target : symbols.jumpTargets) {
     if (!symbols.labels.count(target)) {
       throw std::runtime_error(
           "Error Semántico: Se hace referencia a la etiqueta no definida '" +
-          target + "' en un comando 'jump' o 'choice'.");
+          std::string(nameOf(target)) + "' en un comando 'jump' o 'choice'.");
     }
   }
+}
 
+std::unique_ptr<ProgramNode> Parser::parseProgram() {
+  auto program = std::make_unique<ProgramNode>(compilerPath);
+  parseStatements(program->statements);
+  checkJumpTargets(symbols);
+  program->arenas.push_back(releaseArena());
   return program;
 }
 
-std::unique_ptr<BackgroundNode> Parser::parseBackground() {
-  auto node = std::make_unique<BackgroundNode>();
+const std::array<Parser::StatementRule, TOKEN_TYPE_COUNT>
+    Parser::statementRules = [] {
+      std::array<StatementRule, TOKEN_TYPE_COUNT> rules{};
+      auto add = [&rules](TokenType type, ASTNode *(Parser::*parse)(),
+                          uint8_t scopes) {
+        rules[static_cast<size_t>(type)] = {parse, scopes};
+      };
+      constexpr uint8_t ANYWHERE = TOP_LEVEL | IN_LABEL;
+      add(TokenType::BACKGROUND,
+          &Parser::parseAs<BackgroundNode, &Parser::parseBackground>,
+          TOP_LEVEL);
+      add(TokenType::DEFINE,
+          &Parser::parseAs<CharacterNode, &Parser::parseDefine>, TOP_LEVEL);
+      add(TokenType::MUSIC, &Parser::parseAs<MusicNode, &Parser::parseMusic>,
+          TOP_LEVEL);
+      add(TokenType::IMPORT,
+          &Parser::parseAs<ImportNode, &Parser::parseImport>, TOP_LEVEL);
+      add(TokenType::LABEL, &Parser::parseAs<LabelNode, &Parser::parseLabel>,
+          TOP_LEVEL);
+      add(TokenType::SCENE, &Parser::parseAs<SceneNode, &Parser::parseScene>,
+          ANYWHERE);
+      add(TokenType::SHOW, &Parser::parseAs<ShowNode, &Parser::parseShow>,
+          ANYWHERE);
+      add(TokenType::HIDE, &Parser::parseAs<HideNode, &Parser::parseHide>,
+          ANYWHERE);
+      add(TokenType::STRING,
+          &Parser::parseAs<DialogueNode, &Parser::parseDialogue>, ANYWHERE);
+      add(TokenType::IDENTIFIER,
+          &Parser::parseAs<DialogueNode, &Parser::parseDialogue>, ANYWHERE);
+      add(TokenType::PLAY, &Parser::parseAs<PlayNode, &Parser::parsePlay>,
+          ANYWHERE);
+      add(TokenType::STOP, &Parser::parseAs<StopNode, &Parser::parseStop>,
+          ANYWHERE);
+      add(TokenType::CHOICE,
+          &Parser::parseAs<ChoiceNode, &Parser::parseChoice>, ANYWHERE);
+      add(TokenType::JUMP, &Parser::parseAs<JumpNode, &Parser::parseJump>,
+          ANYWHERE);
+      add(TokenType::END, &Parser::parseAs<EndNode, &Parser::parseEnd>,
+          ANYWHERE);
+      return rules;
+    }();
+
+void Parser::parseStatements(NodeList &statements) {
+  while (current.type != TokenType::END_OF_FILE)
+    statements.push_back(parseStatement(TOP_LEVEL));
+}
+
+ASTNode *Parser::parseStatement(StatementScope scope) {
+  const StatementRule &rule =
+      statementRules[static_cast<size_t>(current.type)];
+  if (rule.scopes & scope)
+    return (this->*rule.parse)();
+
+  if (scope == IN_LABEL && (rule.scopes & TOP_LEVEL)) {
+    throw std::runtime_error(
+        "[Línea " + std::to_string(current.line) +
+        "] Error: Las definiciones de assets (background, define, music) "
+        "deben estar fuera de las etiquetas.");
+  }
+  if (scope == IN_LABEL) {
+    throw std::runtime_error("[Línea " + std::to_string(current.line) +
+                             "] Sentencia inválida dentro de la etiqueta '" +
+                             std::string(nameOf(currentLabel)) + "'.");
+  }
+  throw std::runtime_error("[Línea " + std::to_string(current.line) +
+                           "] Sentencia inválida");
+}
+
+BackgroundNode *Parser::parseBackground() {
+  auto node = arena->make<BackgroundNode>();
 
   advance();
-  node->name = current.value;
+  node->name = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba nombre de fondo");
 
   if (symbols.backgrounds.count(node->name)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
-                             "] Error Semántico: El fondo '" + node->name +
+                             "] Error Semántico: El fondo '" +
+                             std::string(nameOf(node->name)) +
                              "' ya ha sido definido.");
   }
   symbols.backgrounds.insert(node->name);
@@ -143,16 +181,17 @@ std::unique_ptr<BackgroundNode> Parser::parseBackground() {
   return node;
 }
 
-std::unique_ptr<CharacterNode> Parser::parseDefine() {
-  auto node = std::make_unique<CharacterNode>();
+CharacterNode *Parser::parseDefine() {
+  auto node = arena->make<CharacterNode>();
 
   advance();
-  node->id = current.value;
+  node->id = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba ID de personaje");
 
   if (symbols.characters.count(node->id)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
-                             "] Error Semántico: El personaje '" + node->id +
+                             "] Error Semántico: El personaje '" +
+                             std::string(nameOf(node->id)) +
                              "' ya ha sido definido.");
   }
   symbols.characters[node->id] = {};
@@ -168,11 +207,13 @@ std::unique_ptr<CharacterNode> Parser::parseDefine() {
     if (symbols.characters.at(node->id).count(mode_node->name)) {
       throw std::runtime_error(
           "[Línea " + std::to_string(current.line) +
-          "] Error Semántico: El modo '" + mode_node->name +
-          "' ya está definido para el personaje '" + node->id + "'.");
+          "] Error Semántico: El modo '" +
+          std::string(nameOf(mode_node->name)) +
+          "' ya está definido para el personaje '" +
+          std::string(nameOf(node->id)) + "'.");
     }
     symbols.characters.at(node->id).insert(mode_node->name);
-    node->modes.push_back(std::move(mode_node));
+    node->modes.push_back(mode_node);
 
     if (current.type == TokenType::COMMA) {
       advance();
@@ -183,51 +224,56 @@ std::unique_ptr<CharacterNode> Parser::parseDefine() {
   return node;
 }
 
-std::unique_ptr<SceneNode> Parser::parseScene() {
-  auto node = std::make_unique<SceneNode>();
+SceneNode *Parser::parseScene() {
+  auto node = arena->make<SceneNode>();
 
   advance();
-  node->name = current.value;
+  node->name = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba nombre de escena o fondo");
 
-  if (!symbols.backgrounds.count(node->name)) {
+  if (!symbols.backgrounds.count(node->name) &&
+      !defer(RefKind::BACKGROUND, node->name)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
-                             "] Error Semántico: El fondo '" + node->name +
+                             "] Error Semántico: El fondo '" +
+                             std::string(nameOf(node->name)) +
                              "' no ha sido definido.");
   }
 
-  std::unordered_map<std::string, ParameterValue> parametros;
   if (current.type == TokenType::LPAREN) {
     advance();
-    parseParameters(IMAGE, parametros);
+    parseParameters(IMAGE, node->parameters);
     expect(TokenType::RPAREN, "Se esperaba ')'");
   }
 
-  node->parameters = parametros;
   return node;
 }
 
-std::unique_ptr<ShowNode> Parser::parseShow() {
-  auto node = std::make_unique<ShowNode>();
+ShowNode *Parser::parseShow() {
+  auto node = arena->make<ShowNode>();
 
   advance();
-  node->characterId = current.value;
+  node->characterId = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba nombre del personaje");
 
-  if (!symbols.characters.count(node->characterId)) {
+  bool known = symbols.characters.count(node->characterId);
+  if (!known && !deferChecks) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
                              "] Error Semántico: El personaje '" +
-                             node->characterId + "' no ha sido definido.");
+                             std::string(nameOf(node->characterId)) +
+                             "' no ha sido definido.");
   }
 
-  node->mode = current.value;
+  node->mode = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba el modo del personaje");
 
-  if (!symbols.characters.at(node->characterId).count(node->mode)) {
+  if (!known) {
+    defer(RefKind::MODE, node->characterId, node->mode);
+  } else if (!symbols.characters.at(node->characterId).count(node->mode)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
-                             "] Error Semántico: El modo '" + node->mode +
+                             "] Error Semántico: El modo '" +
+                             std::string(nameOf(node->mode)) +
                              "' no está definido para el personaje '" +
-                             node->characterId + "'.");
+                             std::string(nameOf(node->characterId)) + "'.");
   }
 
   if (current.type == TokenType::LPAREN) {
@@ -239,10 +285,10 @@ std::unique_ptr<ShowNode> Parser::parseShow() {
   return node;
 }
 
-std::unique_ptr<HideNode> Parser::parseHide() {
-  auto node = std::make_unique<HideNode>();
+HideNode *Parser::parseHide() {
+  auto node = arena->make<HideNode>();
   advance();
-  node->characterId = current.value;
+  node->characterId = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba nombre del personaje o imagen");
 
   if (current.type == TokenType::LPAREN) {
@@ -251,33 +297,31 @@ std::unique_ptr<HideNode> Parser::parseHide() {
     expect(TokenType::RPAREN, "Se esperaba ')'");
   }
 
-  if (!symbols.characters.count(node->characterId)) {
+  if (!symbols.characters.count(node->characterId) &&
+      !defer(RefKind::CHARACTER, node->characterId)) {
     throw std::runtime_error(
         "[Línea " + std::to_string(current.line) +
         "] Error Semántico: Intento de ocultar personaje no definido '" +
-        node->characterId + "'.");
+        std::string(nameOf(node->characterId)) + "'.");
   }
   return node;
 }
 
-std::unique_ptr<DialogueNode> Parser::parseDialogue() {
-  auto node = std::make_unique<DialogueNode>();
+DialogueNode *Parser::parseDialogue() {
+  auto node = arena->make<DialogueNode>();
 
-  std::unordered_map<std::string, ParameterValue> parametro;
   if (current.type == TokenType::STRING) {
-    node->speaker = "You";
+    node->speaker = intern("You");
     node->text = current.value;
     advance();
 
     if (current.type == TokenType::LPAREN) {
       advance();
-      parseParameters(DIALOGUE, parametro);
+      parseParameters(DIALOGUE, node->parameters);
       expect(TokenType::RPAREN, "Se esperaba ')'");
     }
-
-    node->parameters = parametro;
   } else if (current.type == TokenType::IDENTIFIER) {
-    node->speaker = current.value;
+    node->speaker = current.symbol;
     advance();
 
     node->text = current.value;
@@ -285,20 +329,17 @@ std::unique_ptr<DialogueNode> Parser::parseDialogue() {
 
     if (current.type == TokenType::LPAREN) {
       advance();
-      parseParameters(DIALOGUE, parametro);
+      parseParameters(DIALOGUE, node->parameters);
       expect(TokenType::RPAREN, "Se esperaba ')'");
     }
 
-    node->parameters = parametro;
   } else {
     throw std::runtime_error("Diálogo inválido");
   }
   return node;
 }
 
-void Parser::parseParameters(
-    ParameterMode mode,
-    std::unordered_map<std::string, ParameterValue> &parameters) {
+void Parser::parseParameters(ParameterMode mode, Parameters &parameters) {
   parseParameter(mode, parameters);
   while (current.type == TokenType::COMMA) {
     advance();
@@ -306,32 +347,27 @@ void Parser::parseParameters(
   }
 }
 
-void Parser::parseParameter(
-    ParameterMode mode,
-    std::unordered_map<std::string, ParameterValue> &parameters) {
-  std::string name = current.value;
+void Parser::parseParameter(ParameterMode mode, Parameters &parameters) {
+  std::string name(current.value);
   expect(TokenType::IDENTIFIER, "Se esperaba nombre de parámetro");
   expect(TokenType::COLON, "Se esperaba ':'");
   if (current.type == TokenType::INT || current.type == TokenType::FLOAT ||
       current.type == TokenType::IDENTIFIER ||
       current.type == TokenType::STRING) {
-    ParameterValue realValue;
-
     if (mode == IMAGE)
-      checkParameterImage(name, current.value, realValue);
+      checkParameterImage(name, current.value, parameters);
     else if (mode == DIALOGUE)
-      checkParameterDialogue(name, current.value, realValue);
+      checkParameterDialogue(name, current.value, parameters);
 
-    parameters[name] = realValue;
     advance();
   } else {
     throw std::runtime_error("Valor de parámetro inválido");
   }
 }
 
-std::unique_ptr<CharacterModeData> Parser::parseMode() {
-  auto node = std::make_unique<CharacterModeData>();
-  node->name = current.value;
+CharacterModeData *Parser::parseMode() {
+  auto node = arena->make<CharacterModeData>();
+  node->name = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba nombre de modo");
 
   expect(TokenType::COLON, "Se esperaba ':'");
@@ -350,17 +386,18 @@ std::unique_ptr<CharacterModeData> Parser::parseMode() {
   return node;
 }
 
-std::unique_ptr<MusicNode> Parser::parseMusic() {
-  auto node = std::make_unique<MusicNode>();
+MusicNode *Parser::parseMusic() {
+  auto node = arena->make<MusicNode>();
 
   advance();
-  node->id = current.value;
+  node->id = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba un ID para la música");
 
   if (symbols.music.count(node->id)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
                              "] Error Semántico: La pista de música '" +
-                             node->id + "' ya ha sido definida.");
+                             std::string(nameOf(node->id)) +
+                             "' ya ha sido definida.");
   }
   symbols.music.insert(node->id);
 
@@ -369,38 +406,42 @@ std::unique_ptr<MusicNode> Parser::parseMusic() {
   return node;
 }
 
-std::unique_ptr<PlayNode> Parser::parsePlay() {
-  auto node = std::make_unique<PlayNode>();
+PlayNode *Parser::parsePlay() {
+  auto node = arena->make<PlayNode>();
 
   advance();
-  node->musicId = current.value;
+  node->musicId = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba el ID de la música a reproducir");
 
-  if (!symbols.music.count(node->musicId)) {
+  if (!symbols.music.count(node->musicId) &&
+      !defer(RefKind::MUSIC, node->musicId)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
                              "] Error Semántico: La pista de música '" +
-                             node->musicId + "' no ha sido definida.");
+                             std::string(nameOf(node->musicId)) +
+                             "' no ha sido definida.");
   }
   return node;
 }
 
-std::unique_ptr<StopNode> Parser::parseStop() {
-  auto node = std::make_unique<StopNode>();
+StopNode *Parser::parseStop() {
+  auto node = arena->make<StopNode>();
 
   advance();
-  node->musicId = current.value;
+  node->musicId = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba el ID de la música a detener");
 
-  if (!symbols.music.count(node->musicId)) {
+  if (!symbols.music.count(node->musicId) &&
+      !defer(RefKind::MUSIC, node->musicId)) {
     throw std::runtime_error("[Línea " + std::to_string(current.line) +
                              "] Error Semántico: La pista de música '" +
-                             node->musicId + "' no ha sido definida.");
+                             std::string(nameOf(node->musicId)) +
+                             "' no ha sido definida.");
   }
   return node;
 }
 
-std::unique_ptr<ChoiceNode> Parser::parseChoice() {
-  auto node = std::make_unique<ChoiceNode>();
+ChoiceNode *Parser::parseChoice() {
+  auto node = arena->make<ChoiceNode>();
 
   advance();
   node->prompt = current.value;
@@ -408,28 +449,28 @@ std::unique_ptr<ChoiceNode> Parser::parseChoice() {
          "Se esperaba un string para el prompt de la elección");
 
   while (current.type == TokenType::OPTION) {
-    auto optionNode = std::make_unique<OptionNode>();
+    auto optionNode = arena->make<OptionNode>();
     advance();
     optionNode->text = current.value;
     expect(TokenType::STRING,
            "Se esperaba un string para el texto de la opción");
     expect(TokenType::ARROW, "Se esperaba '->' después del texto de la opción");
-    optionNode->gotoLabel = current.value;
+    optionNode->gotoLabel = current.symbol;
     expect(TokenType::IDENTIFIER,
            "Se esperaba un identificador para la etiqueta de salto");
 
-    symbols.jumpTargets.insert(optionNode->gotoLabel);
-    node->options.push_back(std::move(optionNode));
+    symbols.jumpTargets.push_back(optionNode->gotoLabel);
+    node->options.push_back(optionNode);
   }
 
   return node;
 }
 
-std::unique_ptr<LabelNode> Parser::parseLabel() {
-  auto node = std::make_unique<LabelNode>();
+LabelNode *Parser::parseLabel() {
+  auto node = arena->make<LabelNode>();
 
   advance();
-  node->name = current.value;
+  node->name = current.symbol;
   expect(TokenType::IDENTIFIER,
          "Se esperaba un identificador para la etiqueta");
 
@@ -437,61 +478,45 @@ std::unique_ptr<LabelNode> Parser::parseLabel() {
 
   expect(TokenType::COLON, "Se esperaba ':' después del nombre de la etiqueta");
 
+  currentLabel = node->name;
   while (current.type != TokenType::LABEL &&
+         current.type != TokenType::IMPORT &&
          current.type != TokenType::END_OF_FILE) {
-    if (isBackground()) {
-      node->statements.push_back(parseBackground());
-    } else if (isDefine()) {
-      node->statements.push_back(parseDefine());
-    } else if (isScene()) {
-      node->statements.push_back(parseScene());
-    } else if (isShow()) {
-      node->statements.push_back(parseShow());
-    } else if (isHide()) {
-      node->statements.push_back(parseHide());
-    } else if (isDialogue()) {
-      node->statements.push_back(parseDialogue());
-    } else if (isMusic()) {
-      node->statements.push_back(parseMusic());
-    } else if (isPlay()) {
-      node->statements.push_back(parsePlay());
-    } else if (isStop()) {
-      node->statements.push_back(parseStop());
-    } else if (isChoice()) {
-      node->statements.push_back(parseChoice());
-    } else if (isJump()) {
-      node->statements.push_back(parseJump());
-    } else if (isEnd()) {
-      node->statements.push_back(parseEnd());
-    } else {
-      if (isBackground() || isDefine() || isMusic()) {
-        throw std::runtime_error(
-            "[Línea " + std::to_string(current.line) +
-            "] Error: Las definiciones de assets (background, define, music) "
-            "deben estar fuera de las etiquetas.");
-      }
-      throw std::runtime_error("[Línea " + std::to_string(current.line) +
-                               "] Sentencia inválida dentro de la etiqueta '" +
-                               node->name + "'.");
-    }
+    node->statements.push_back(parseStatement(IN_LABEL));
   }
 
   return node;
 }
 
-std::unique_ptr<JumpNode> Parser::parseJump() {
-  auto node = std::make_unique<JumpNode>();
+JumpNode *Parser::parseJump() {
+  auto node = arena->make<JumpNode>();
 
   advance();
-  node->target = current.value;
+  node->target = current.symbol;
   expect(TokenType::IDENTIFIER, "Se esperaba el ID de la etiqueta a ir");
 
-  symbols.jumpTargets.insert(node->target);
+  symbols.jumpTargets.push_back(node->target);
+  return node;
+}
+
+EndNode *Parser::parseEnd() {
+  advance();
+  auto node = arena->make<EndNode>();
   return node;
 }
 
-std::unique_ptr<EndNode> Parser::parseEnd() {
+ImportNode *Parser::parseImport() {
+  auto node = arena->make<ImportNode>();
+
   advance();
-  auto node = std::make_unique<EndNode>();
+  node->path = current.value;
+  expect(TokenType::STRING, "Se esperaba la ruta del módulo a importar");
   return node;
 }
+
+bool Parser::defer(RefKind kind, Symbol name, Symbol mode) {
+  if (!deferChecks)
+    return false;
+  symbols.unresolved.push_back({kind, name, mode, current.line});
+  return true;
+}
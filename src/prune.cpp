@@ -0,0 +1,84 @@
+#include <cfg.hpp>
+#include <prune.hpp>
+#include <unordered_map>
+
+namespace {
+
+struct AssetUsage {
+  SymbolSet backgrounds;
+  SymbolSet music;
+  SymbolSet characters;
+  std::unordered_map<Symbol, SymbolSet> modes;
+};
+
+AssetUsage collectUsage(const FlatProgram &program) {
+  AssetUsage used;
+  for (const FlatLabel &label : program.labels) {
+    Range live = liveStmts(program, label);
+    for (uint32_t s = live.first; s < live.end(); ++s) {
+      const Stmt &stmt = program.stmts[s];
+      switch (stmt.kind) {
+      case StmtKind::SCENE:
+        used.backgrounds.insert(program.scenes[stmt.index].background);
+        break;
+      case StmtKind::SHOW: {
+        const FlatShow &show = program.shows[stmt.index];
+        used.characters.insert(show.character);
+        used.modes[show.character].insert(show.mode);
+        break;
+      }
+      case StmtKind::HIDE:
+        used.characters.insert(program.hides[stmt.index].character);
+        break;
+      case StmtKind::DIALOGUE:
+        used.characters.insert(program.dialogues[stmt.index].speaker);
+        break;
+      case StmtKind::PLAY:
+        used.music.insert(program.plays[stmt.index].music);
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  return used;
+}
+
+template <typename T, typename Keep>
+void keepIf(std::vector<T> &items, Keep keep) {
+  size_t kept = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (keep(items[i]))
+      items[kept++] = items[i];
+  }
+  items.resize(kept);
+}
+
+} // namespace
+
+void pruneUnusedAssets(FlatProgram &program) {
+  AssetUsage used = collectUsage(program);
+
+  keepIf(program.backgrounds, [&](const FlatBackground &background) {
+    return used.backgrounds.count(background.name);
+  });
+  keepIf(program.music,
+         [&](const FlatMusic &music) { return used.music.count(music.id); });
+  keepIf(program.characters, [&](const FlatCharacter &character) {
+    return used.characters.count(character.id);
+  });
+
+  // Modes are compacted in place; a character's kept modes never move past
+  // where they were.
+  uint32_t kept = 0;
+  for (FlatCharacter &character : program.characters) {
+    const SymbolSet &shown = used.modes[character.id];
+    uint32_t first = kept;
+    for (uint32_t m = character.modes.first; m < character.modes.end(); ++m) {
+      if (shown.count(program.modes[m].name))
+        program.modes[kept++] = program.modes[m];
+    }
+    character.modes = {first, kept - first};
+  }
+  program.modes.resize(kept);
+}
@@ -0,0 +1,181 @@
+#include <scan.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+namespace {
+
+inline bool isSpace(unsigned char c) {
+  return c == ' ' || (c >= 9 && c <= 13);
+}
+
+const char *scanStringScalar(const char *p, const char *end) {
+  while (p < end && *p != '"' && *p != '\\' && *p != '\n')
+    ++p;
+  return p;
+}
+
+const char *scanLineScalar(const char *p, const char *end) {
+  while (p < end && *p != '\n')
+    ++p;
+  return p;
+}
+
+const char *skipSpaceScalar(const char *p, const char *end, int &lines) {
+  while (p < end && isSpace(*p)) {
+    if (*p == '\n')
+      ++lines;
+    ++p;
+  }
+  return p;
+}
+
+#ifdef SCAN_X86
+
+__attribute__((target("sse2"))) const char *scanStringSse2(const char *p,
+                                                           const char *end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i slash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hit = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+        _mm_cmpeq_epi8(v, newline));
+    int mask = _mm_movemask_epi8(hit);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+  return scanStringScalar(p, end);
+}
+
+__attribute__((target("sse2"))) const char *scanLineSse2(const char *p,
+                                                         const char *end) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+  return scanLineScalar(p, end);
+}
+
+// Whitespace is ' ' or the range '\t'..'\r': after subtracting '\t' the
+// range check becomes an unsigned min/compare.
+__attribute__((target("sse2"))) const char *
+skipSpaceSse2(const char *p, const char *end, int &lines) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i four = _mm_set1_epi8(4);
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i t = _mm_sub_epi8(v, tab);
+    __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                              _mm_cmpeq_epi8(_mm_min_epu8(t, four), t));
+    unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xFFFFu;
+    unsigned nl = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline));
+    if (stop) {
+      unsigned n = __builtin_ctz(stop);
+      lines += __builtin_popcount(nl & ((1u << n) - 1));
+      return p + n;
+    }
+    lines += __builtin_popcount(nl);
+  }
+  return skipSpaceScalar(p, end, lines);
+}
+
+__attribute__((target("avx2"))) const char *scanStringAvx2(const char *p,
+                                                           const char *end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i slash = _mm256_set1_epi8('\\');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i hit = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                        _mm256_cmpeq_epi8(v, slash)),
+        _mm256_cmpeq_epi8(v, newline));
+    unsigned mask = _mm256_movemask_epi8(hit);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+  return scanStringSse2(p, end);
+}
+
+__attribute__((target("avx2"))) const char *scanLineAvx2(const char *p,
+                                                         const char *end) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+  return scanLineSse2(p, end);
+}
+
+__attribute__((target("avx2"))) const char *
+skipSpaceAvx2(const char *p, const char *end, int &lines) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i four = _mm256_set1_epi8(4);
+  const __m256i newline = _mm256_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i t = _mm256_sub_epi8(v, tab);
+    __m256i ws =
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                        _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t));
+    unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+    unsigned nl = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+    if (stop) {
+      unsigned n = __builtin_ctz(stop);
+      lines += __builtin_popcount(nl & ((1u << n) - 1));
+      return p + n;
+    }
+    lines += __builtin_popcount(nl);
+  }
+  return skipSpaceSse2(p, end, lines);
+}
+
+#endif
+
+struct ScanKernels {
+  const char *(*string)(const char *, const char *);
+  const char *(*line)(const char *, const char *);
+  const char *(*space)(const char *, const char *, int &);
+};
+
+ScanKernels selectKernels() {
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return {scanStringAvx2, scanLineAvx2, skipSpaceAvx2};
+  if (__builtin_cpu_supports("sse2"))
+    return {scanStringSse2, scanLineSse2, skipSpaceSse2};
+#endif
+  return {scanStringScalar, scanLineScalar, skipSpaceScalar};
+}
+
+const ScanKernels &kernels() {
+  static const ScanKernels selected = selectKernels();
+  return selected;
+}
+
+} // namespace
+
+const char *scanString(const char *p, const char *end) {
+  return kernels().string(p, end);
+}
+
+const char *scanLine(const char *p, const char *end) {
+  return kernels().line(p, end);
+}
+
+const char *skipSpace(const char *p, const char *end, int &lines) {
+  return kernels().space(p, end, lines);
+}
@@ -0,0 +1,71 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <source.hpp>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::SourceFile(const char *path, Mode mode) {
+  if (std::strcmp(path, "-") == 0) {
+    readAll();
+    return;
+  }
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("No se pudo abrir " + std::string(path) + ": " +
+                             std::strerror(errno));
+  }
+
+  struct stat info;
+  bool regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+  if (mode == Mode::MAP && regular && info.st_size > 0) {
+    void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      mapped = static_cast<char *>(addr);
+      mappedLen = info.st_size;
+      madvise(mapped, mappedLen, MADV_SEQUENTIAL);
+      return;
+    }
+  }
+
+  // The destructor does not run when the constructor throws.
+  try {
+    if (regular)
+      buffer.reserve(info.st_size);
+    readAll();
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+}
+
+SourceFile::~SourceFile() {
+  if (mapped)
+    munmap(mapped, mappedLen);
+  if (fd >= 0)
+    close(fd);
+}
+
+void SourceFile::readAll() {
+  int in = fd >= 0 ? fd : STDIN_FILENO;
+  char chunk[BUFFER_SIZE];
+  ssize_t n;
+  while ((n = read(in, chunk, BUFFER_SIZE)) != 0) {
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error(std::string("Error de lectura: ") +
+                               std::strerror(errno));
+    }
+    buffer.append(chunk, n);
+  }
+}
+
+std::string_view SourceFile::text() const {
+  if (mapped)
+    return {mapped, mappedLen};
+  return buffer;
+}
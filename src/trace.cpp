@@ -0,0 +1,92 @@
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <trace.hpp>
+
+namespace {
+
+// Small sequential thread ids read better in the viewer than hashed ones.
+uint32_t threadId() {
+  static std::atomic<uint32_t> next{1};
+  thread_local uint32_t id = next++;
+  return id;
+}
+
+void writeString(std::ostream &out, const std::string &s) {
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      out << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      out << ' ';
+    else
+      out << c;
+  }
+  out << '"';
+}
+
+} // namespace
+
+int64_t Tracer::now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+void Tracer::start(const std::string &file) {
+  std::lock_guard<std::mutex> lock(mutex);
+  path = file;
+  epoch = std::chrono::steady_clock::now();
+  threadId();
+  enabled = true;
+}
+
+void Tracer::span(const char *name, int64_t begin, std::string detail) {
+  int64_t end = now();
+  std::lock_guard<std::mutex> lock(mutex);
+  events.push_back(
+      {name, 'X', begin, end - begin, threadId(), 0, std::move(detail)});
+}
+
+void Tracer::add(const char *counter, int64_t amount) {
+  int64_t time = now();
+  std::lock_guard<std::mutex> lock(mutex);
+  int64_t &total = totals[counter];
+  total += amount;
+  events.push_back({counter, 'C', time, 0, threadId(), total, {}});
+}
+
+void Tracer::finish() {
+  if (!active())
+    return;
+  enabled = false;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::ofstream out(path);
+  if (!out.is_open())
+    throw std::runtime_error("No se pudo abrir " + path + " para escribir.");
+
+  out << "{\"traceEvents\": [\n";
+  for (size_t i = 0; i < events.size(); ++i) {
+    const Event &event = events[i];
+    out << "  {\"name\": ";
+    writeString(out, event.name);
+    out << ", \"ph\": \"" << event.phase << "\", \"ts\": " << event.time
+        << ", \"pid\": 1, \"tid\": " << event.thread;
+    if (event.phase == 'X') {
+      out << ", \"dur\": " << event.duration;
+      if (!event.detail.empty()) {
+        out << ", \"args\": {\"detail\": ";
+        writeString(out, event.detail);
+        out << "}";
+      }
+    } else {
+      out << ", \"args\": {\"value\": " << event.value << "}";
+    }
+    out << (i + 1 < events.size() ? "},\n" : "}\n");
+  }
+  out << "], \"displayTimeUnit\": \"ms\"}\n";
+  events.clear();
+  if (!out)
+    throw std::runtime_error("No se pudo escribir " + path + ".");
+}
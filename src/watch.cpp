@@ -0,0 +1,70 @@
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <watch.hpp>
+
+namespace fs = std::filesystem;
+
+FileWatcher::FileWatcher() {
+  fd = inotify_init1(IN_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error(std::string("No se pudo iniciar inotify: ") +
+                             std::strerror(errno));
+  }
+}
+
+FileWatcher::~FileWatcher() { close(fd); }
+
+void FileWatcher::watch(const std::vector<std::string> &paths) {
+  files.clear();
+  for (const std::string &path : paths) {
+    fs::path file = fs::absolute(path).lexically_normal();
+    files.insert(file.string());
+    std::string dir = file.parent_path().string();
+    int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+      throw std::runtime_error("No se pudo vigilar " + dir + ": " +
+                               std::strerror(errno));
+    }
+    dirs[wd] = dir;
+  }
+}
+
+bool FileWatcher::matches(const char *events, size_t size) const {
+  for (size_t offset = 0; offset < size;) {
+    auto event = reinterpret_cast<const inotify_event *>(events + offset);
+    offset += sizeof(inotify_event) + event->len;
+    auto dir = dirs.find(event->wd);
+    if (event->len > 0 && dir != dirs.end() &&
+        files.count(dir->second + "/" + event->name))
+      return true;
+  }
+  return false;
+}
+
+bool FileWatcher::wait() {
+  alignas(inotify_event) char events[4096];
+  bool changed = false;
+  while (!changed) {
+    ssize_t n = read(fd, events, sizeof(events));
+    if (n < 0) {
+      if (errno == EINTR)
+        return false;
+      throw std::runtime_error(std::string("Error de lectura: ") +
+                               std::strerror(errno));
+    }
+    changed = matches(events, n);
+  }
+
+  pollfd quiet{fd, POLLIN, 0};
+  int ready;
+  while ((ready = poll(&quiet, 1, SETTLE_MS)) > 0) {
+    if (read(fd, events, sizeof(events)) < 0 && errno != EAGAIN)
+      break;
+  }
+  return !(ready < 0 && errno == EINTR);
+}